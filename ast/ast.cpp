@@ -8,7 +8,7 @@ std::string Node::String()
 {
     if(node_type == "Identifier")
     {
-        if(which_identifier == "IntegerLiteral")
+        if(which_identifier == "IntegerLiteral" || which_identifier == "FloatLiteral")
         {
             return token.Literal;
         }
@@ -42,6 +42,10 @@ std::string Node::String()
         {
             return "while" + Condition_identifier->String() + " " + Consequence_statement->String();
         }
+        else if(which_identifier == "ForExpression")
+        {
+            return "for(" + Name_identifier->String() + " in " + Value_identifier->String() + ") " + Body_statement->String();
+        }
         else if(which_identifier == "FunctionLiteral")
         {
             std::string output_str = TokenLiteral()+"(";
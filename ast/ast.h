@@ -1,18 +1,24 @@
 #ifndef __AST_HEADER__
 #define __AST_HEADER__
 
+#include <cstdint>
 #include <iostream>
 #include <vector>
 #include "../token/token.h"
+#include "../memory/arena.h"
 
 class Statement;
+class Shape;
+class Object;
+struct NativeEntry;
 
 class Node
 {
     public:
         std::string Value_type;
-        int Value_int;
-        bool Value_bool;
+        long Value_int = 0;
+        double Value_float = 0;
+        bool Value_bool = false;
         std::string Value_string;
         Token token;
         std::string Value;
@@ -20,27 +26,40 @@ class Node
         std::string which_identifier;
         std::string which_statement;
         std::string Operator;
-        std::unordered_map<Node*, Node*> Pairs;
+        std::vector<std::pair<Node*, Node*>> Pairs;
         std::vector<Node *> Node_array;
-        Node *Right_identifier;
-        Node *Left_identifier;
-        Node *Condition_identifier;
-        Node *Consequence_statement;
-        Node *Alternative_statement;
-        Node *Body_statement;
-        Node *Function_identifier;
-        Node *Name_identifier;
-        Node *Value_identifier;
-        Node *ReturnValue_identifier;
-        Node *Expression_identifier;
-        Node *Left_index;
-        Node *Right_index;
-        Node *Index;
+        Node *Right_identifier = NULL;
+        Node *Left_identifier = NULL;
+        Node *Condition_identifier = NULL;
+        Node *Consequence_statement = NULL;
+        Node *Alternative_statement = NULL;
+        Node *Body_statement = NULL;
+        Node *Function_identifier = NULL;
+        Node *Name_identifier = NULL;
+        Node *Value_identifier = NULL;
+        Node *ReturnValue_identifier = NULL;
+        Node *Expression_identifier = NULL;
+        Node *Left_index = NULL;
+        Node *Right_index = NULL;
+        Node *Index = NULL;
+        // inline cache of an IndexExpression with a string literal key
+        const Shape *Cache_shape = NULL;
+        int Cache_slot = 0;
+        // inline cache of an Identifier, the globalId of its name and the hash it is looked up with
+        long Cache_global = -1;
+        std::uint64_t Cache_name_hash = 0;
+        // inline cache of a CallExpression, the native its callee named when the registry was at
+        // Cache_generation
+        const NativeEntry *Cache_native = NULL;
+        unsigned long Cache_generation = 0;
 
 
         std::string TokenLiteral();
         std::string String();
-        
+
+        static void *operator new(std::size_t size) { return MyMemory::allocate(size, &MyMemory::destroy<Node>, MyMemory::NODE_BLOCK); }
+        static void operator delete(void *ptr) { MyMemory::release(ptr); }
+
 };
 
 #endif
\ No newline at end of file
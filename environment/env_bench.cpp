@@ -0,0 +1,104 @@
+#include "environment.h"
+#include "../object/object.h"
+#include <chrono>
+
+// g++ -std=c++17 -O2 environment/env_bench.cpp object/array_kernels.cpp object/array_storage.cpp object/bigint.cpp
+//     object/hash_table.cpp object/object.cpp object/persistent.cpp object/string_kernels.cpp object/utf8.cpp
+//     memory/arena.cpp memory/heap.cpp memory/profiler.cpp memory/promote.cpp ast/ast.cpp environment/environment.cpp
+//     token/token.cpp -pthread
+
+double msSince(std::chrono::steady_clock::time_point start)
+{
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+// what a call does to its Env: bind the parameters and a few locals, then read them back a few times;
+// identifiers keep the hash of their name, so the scope is handed hashes worked out once
+void BenchCallScopes(long calls, int bindings)
+{
+    std::vector<std::string> names;
+    std::vector<std::uint64_t> hashes;
+    for(int i = 0; i < bindings; i++)
+    {
+        names.push_back("local_" + std::string(1, 'a' + i));
+        hashes.push_back(MyEnv::hashName(names.back()));
+    }
+    Object *value = new Object();
+
+    auto start = std::chrono::steady_clock::now();
+    long found = 0;
+    for(long call = 0; call < calls; call++)
+    {
+        std::unordered_map<std::string, Object*> store;
+        for(auto &name: names)
+            store[name] = value;
+        for(int read = 0; read < 4; read++)
+            for(auto &name: names)
+                found += store.find(name) != store.end();
+    }
+    double map_ns = msSince(start) * 1e6 / calls;
+
+    start = std::chrono::steady_clock::now();
+    for(long call = 0; call < calls; call++)
+    {
+        MyEnv::Scope store;
+        for(int i = 0; i < bindings; i++)
+            store.bind(names[i], hashes[i]) = value;
+        for(int read = 0; read < 4; read++)
+            for(int i = 0; i < bindings; i++)
+                found += store.find(names[i], hashes[i]) != NULL;
+    }
+    double scope_ns = msSince(start) * 1e6 / calls;
+
+    std::cout << bindings << " bindings per call: unordered_map " << map_ns << " ns/call, scope " << scope_ns
+              << " ns/call (" << found << ")\n";
+}
+
+// a name found only in the global Env, looked up from the bottom of a chain of call Envs
+void BenchDeepLookup(int depth, long lookups)
+{
+    MyEnv::Env *global = MyEnv::newEnv();
+    Object *value = new Object();
+    value->which_object = INTEGER_OBJ;
+    long one = 1;
+    setValLong(value, one);
+    for(int i = 0; i < 100; i++)
+        global->setObject("global_" + std::to_string(i), value, global);
+
+    MyEnv::Env *env = global;
+    for(int i = 0; i < depth; i++)
+    {
+        env = MyEnv::newEnclosedEnv(env);
+        env->store.bind("n", MyEnv::hashName("n")) = value;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    long sum = 0;
+    for(long i = 0; i < lookups; i++)
+        sum += env->getObject("global_42", env)->which_object == INTEGER_OBJ;
+    double walk_ns = msSince(start) * 1e6 / lookups;
+
+    // what an identifier site does once it has cached the id of its global
+    long id = MyEnv::globalId("global_42");
+    std::uint64_t hash = MyEnv::hashName("global_42");
+    start = std::chrono::steady_clock::now();
+    for(long i = 0; i < lookups; i++)
+    {
+        Object *found = !MyEnv::mayBeShadowed(hash) ? env->root->getGlobal(id) : env->getObject("global_42", env);
+        sum += found->which_object == INTEGER_OBJ;
+    }
+    double cached_ns = msSince(start) * 1e6 / lookups;
+
+    std::cout << "global through " << depth << " scopes: walking " << walk_ns << " ns, cached site " << cached_ns
+              << " ns (" << sum << ")\n";
+}
+
+int main()
+{
+    BenchCallScopes(1000000, 2);
+    BenchCallScopes(1000000, 8);
+    BenchCallScopes(1000000, 12);
+    BenchDeepLookup(10, 1000000);
+    BenchDeepLookup(100, 100000);
+}
@@ -1,27 +1,144 @@
 #include "../object/object.h"
 #include "environment.h"
+#include "../memory/heap.h"
+#include "../object/hash_table.h"
 
 
-bool MyEnv::Env::isObjectSetted(std::string name, MyEnv::Env *e)
+std::uint64_t MyEnv::hashName(const std::string &name)
 {
-    if(e->store[name])
-        return true;
-    return false;
+    return hashString(name.data(), name.size());
 }
 
+// ids are shared by every root Env, a site that cached one can use it with any of them
+static std::unordered_map<std::string, long> &globalIds()
+{
+    static std::unordered_map<std::string, long> ids;
+    return ids;
+}
+
+// one bit per name hash, set by every binding made outside a root Env, or by any binding at all,
+// and never cleared
+static std::uint64_t shadowed_names[64];
+static std::uint64_t bound_names[64];
+
+static void markName(std::uint64_t *names, std::uint64_t hash)
+{
+    std::uint64_t bit = hash % (64 * 64);
+    names[bit / 64] |= (std::uint64_t)1 << (bit % 64);
+}
+
+static bool nameMarked(const std::uint64_t *names, std::uint64_t hash)
+{
+    std::uint64_t bit = hash % (64 * 64);
+    return (names[bit / 64] >> (bit % 64)) & 1;
+}
 
-Object *MyEnv::Env::getObject(std::string name, MyEnv::Env* e)
+long MyEnv::globalId(const std::string &name)
 {
+    auto found = globalIds().find(name);
+    return found != globalIds().end() ? found->second : -1;
+}
 
-    if(e->store[name])
+bool MyEnv::mayBeShadowed(std::uint64_t hash)
+{
+    return nameMarked(shadowed_names, hash);
+}
+
+bool MyEnv::mayBeBound(std::uint64_t hash)
+{
+    return nameMarked(bound_names, hash);
+}
+
+// names come from the program text, there are only so many of them; filed under their hash, which
+// the caller has already worked out
+static const std::string *internName(const std::string &name, std::uint64_t hash)
+{
+    static std::unordered_multimap<std::uint64_t, std::string> *names = new std::unordered_multimap<std::uint64_t, std::string>();
+    auto range = names->equal_range(hash);
+    for(auto it = range.first; it != range.second; ++it)
     {
-        return e->store[name];
+        if(it->second == name)
+            return &it->second;
     }
-    if(e->has_outer)
+    return &names->emplace(hash, name)->second;
+}
+
+MyEnv::Scope::Scope(const Scope &other)
+{
+    count = other.count;
+    for(std::size_t i = 0; i < count; i++)
     {
-        return getObject(name, e->outer);
+        hashes[i] = other.hashes[i];
+        names[i] = other.names[i];
+        values[i] = other.values[i];
     }
-    
+    if(other.overflow != NULL)
+        overflow.reset(new std::unordered_map<std::string, Object*>(*other.overflow));
+}
+
+Object **MyEnv::Scope::find(const std::string &name, std::uint64_t hash)
+{
+    for(std::size_t i = 0; i < count; i++)
+    {
+        if(hashes[i] == hash && *names[i] == name)
+            return &values[i];
+    }
+    if(overflow == NULL)
+        return NULL;
+    auto found = overflow->find(name);
+    return found != overflow->end() ? &found->second : NULL;
+}
+
+Object *&MyEnv::Scope::bind(const std::string &name, std::uint64_t hash)
+{
+    Object **found = find(name, hash);
+    if(found != NULL)
+        return *found;
+    if(count < INLINE_BINDINGS)
+    {
+        hashes[count] = hash;
+        names[count] = internName(name, hash);
+        values[count] = NULL;
+        return values[count++];
+    }
+    if(overflow == NULL)
+        overflow.reset(new std::unordered_map<std::string, Object*>());
+    return (*overflow)[name];
+}
+
+Object **MyEnv::Env::findSlot(const std::string &name, std::uint64_t hash)
+{
+    if(has_outer)
+        return store.find(name, hash);
+    long id = globalId(name);
+    return id >= 0 && id < (long)globals.size() ? &globals[id] : NULL;
+}
+
+bool MyEnv::Env::isObjectSetted(const std::string &name, MyEnv::Env *e)
+{
+    Object **found = e->findSlot(name, hashName(name));
+    return found != NULL && *found != NULL;
+}
+
+
+// the name is hashed once for the whole walk out through the enclosing scopes
+Object *MyEnv::Env::lookup(const std::string &name, std::uint64_t hash)
+{
+    for(Env *e = this; e != NULL; e = e->has_outer ? e->outer : NULL)
+    {
+        Object **found = e->findSlot(name, hash);
+        if(found != NULL && *found != NULL)
+            return *found;
+    }
+    return NULL;
+}
+
+Object *MyEnv::Env::getObject(const std::string &name, MyEnv::Env* e)
+{
+    Object *found = e->lookup(name, hashName(name));
+    if(found != NULL)
+        return found;
+
     Object *err = new Object();
     err->error_message = "identifier not found: " + name;
     err->which_object = ERROR_OBJ;
@@ -29,17 +146,39 @@ Object *MyEnv::Env::getObject(std::string name, MyEnv::Env* e)
 }
 
 
-void MyEnv::Env::setObject(std::string name, Object *new_object, Env* env)
+void MyEnv::Env::setObject(const std::string &name, Object *new_object, Env* env)
 {
-    env->store[name] = new_object;
+    setObject(name, hashName(name), new_object, env);
+}
+
+void MyEnv::Env::setObject(const std::string &name, std::uint64_t hash, Object *new_object, Env* env)
+{
+    new_object = MyMemory::storable(env, new_object);
+    MyMemory::HeapLock guard(env);
+    Object **slot;
+    markName(bound_names, hash);
+    if(env->has_outer)
+    {
+        markName(shadowed_names, hash);
+        slot = &env->store.bind(name, hash);
+    }
+    else
+    {
+        // the deque only grows at the end, slots handed out before stay where they are
+        long id = globalIds().emplace(name, (long)globalIds().size()).first->second;
+        if(id >= (long)env->globals.size())
+            env->globals.resize(id + 1, NULL);
+        slot = &env->globals[id];
+    }
+    MyMemory::writeBarrier(env, *slot, new_object);
+    *slot = new_object;
 }
 
 MyEnv::Env *MyEnv::newEnv()
 {
     MyEnv::Env *env = new MyEnv::Env();
-    std::unordered_map<std::string, Object*> store;
-    env->store = store;
     env->outer = NULL;
+    env->root = env;
     env->has_outer = false;
     return env;
 }
@@ -48,6 +187,7 @@ MyEnv::Env *MyEnv::newEnclosedEnv(MyEnv::Env *outer)
 {
     MyEnv::Env *env = MyEnv::newEnv();
     env->outer = outer;
+    env->root = outer->root;
     env->has_outer = true;
     return env;
 }
\ No newline at end of file
@@ -1,25 +1,94 @@
 #ifndef __ENV_HEADER__
 #define __ENV_HEADER__
 
+#include <cstdint>
+#include <deque>
 #include <iostream>
+#include <memory>
 #include <unordered_map>
+#include "../memory/arena.h"
 
 class Object;
 
+// bindings a scope keeps inside its Env before it needs a map
+#define INLINE_BINDINGS 8
+
 namespace MyEnv
 {
+    std::uint64_t hashName(const std::string &name);
+    // the dense id a name got when it was first defined in a root Env, -1 if it never was
+    long globalId(const std::string &name);
+    // false only when no function call or for-loop Env has ever bound a name with this hash, an
+    // identifier with such a name can only mean the global
+    bool mayBeShadowed(std::uint64_t hash);
+    // false only when no Env has ever bound a name with this hash
+    bool mayBeBound(std::uint64_t hash);
+
+    // The bindings of one Env. Function calls and blocks rarely bind more than a few names, so the
+    // first INLINE_BINDINGS are kept in arrays inside the Env and found by a linear scan over their
+    // hashes; only bigger scopes, the global one mostly, put the rest in a map made when they do. The
+    // inline names point into a table every bound name is kept in for good, so a scope holds no
+    // strings of its own. A binding never moves once it is made, a pointer to its value stays good
+    // as long as the scope does. Lookups never add anything, only bind() does.
+    class Scope
+    {
+        public:
+            Scope() = default;
+            // the copy gets a map of its own
+            Scope(const Scope &other);
+            Scope &operator=(const Scope &) = delete;
+
+            // NULL when name is not bound here
+            Object **find(const std::string &name, std::uint64_t hash);
+            // the value bound to name, a new NULL binding if there was none
+            Object *&bind(const std::string &name, std::uint64_t hash);
+            std::size_t size() const { return count + (overflow != NULL ? overflow->size() : 0); }
+
+            template<typename F>
+            void forEachBinding(F visit)
+            {
+                for(std::size_t i = 0; i < count; i++)
+                    visit(*names[i], values[i]);
+                if(overflow == NULL)
+                    return;
+                for(auto &vk: *overflow)
+                    visit(vk.first, vk.second);
+            }
+
+        private:
+            std::size_t count = 0;
+            std::uint64_t hashes[INLINE_BINDINGS];
+            const std::string *names[INLINE_BINDINGS];
+            Object *values[INLINE_BINDINGS];
+            std::unique_ptr<std::unordered_map<std::string, Object*>> overflow;
+    };
+
     class Env
     {
         public:
-            std::unordered_map<std::string, Object*> store;
+            Scope store;
+            // a root Env keeps its bindings here by globalId instead of in store
+            std::deque<Object*> globals;
             Env *outer;
+            // the Env at the end of the outer chain, this one for a root Env
+            Env *root;
             bool has_outer;
 
 
-            bool isObjectSetted(std::string name, MyEnv::Env *e);
-            Object *getObject(std::string name, Env* e);
-            void setObject(std::string name, Object *new_object, Env* env);
-            
+            // where name is bound in this Env itself, NULL when it is not
+            Object **findSlot(const std::string &name, std::uint64_t hash);
+            // what name is bound to here or in an enclosing Env, NULL when it is bound nowhere
+            Object *lookup(const std::string &name, std::uint64_t hash);
+            Object *getGlobal(long id) { return id < (long)globals.size() ? globals[id] : NULL; }
+            bool isObjectSetted(const std::string &name, MyEnv::Env *e);
+            Object *getObject(const std::string &name, Env* e);
+            void setObject(const std::string &name, Object *new_object, Env* env);
+            // hash is hashName(name), for callers that keep it
+            void setObject(const std::string &name, std::uint64_t hash, Object *new_object, Env* env);
+
+            static void *operator new(std::size_t size) { return MyMemory::allocate(size, &MyMemory::destroy<Env>, MyMemory::ENV_BLOCK); }
+            static void operator delete(void *ptr) { MyMemory::release(ptr); }
+
     };
 
     Env *newEnv();
@@ -1,56 +1,218 @@
 #include "builtins.h"
-std::unordered_map<std::string, std::function<Object(std::vector<Object *>)>> builtin_functions;
-void registerBuiltinFunctions(std::string func_name, std::function<Object(std::vector<Object *>)> function)
+#include "evaluator.h"
+#include "../memory/heap.h"
+#include "../native/native_module.h"
+#include "../object/array_kernels.h"
+#include "../object/string_kernels.h"
+#include "../object/utf8.h"
+#include <cctype>
+#include <cstring>
+std::unordered_map<std::string, NativeEntry> native_functions;
+unsigned long builtin_generation = 1;
+void registerNative(const std::string &name, NativeFunction function, int min_arity, int max_arity, bool pure)
 {
-    builtin_functions[func_name] = function;
+    NativeEntry &entry = native_functions[name];
+    entry.function = function;
+    entry.min_arity = min_arity;
+    entry.max_arity = max_arity;
+    entry.pure = pure;
+    builtin_generation += 1;
 }
 
-Object builtinLenFunc(std::vector<Object *> arguments)
+void registerNatives(const NativeSpec *specs, std::size_t count)
 {
-    if(arguments.size() != 1)
+    native_functions.reserve(native_functions.size() + count);
+    for(std::size_t i = 0; i < count; i++)
+        registerNative(specs[i].name, specs[i].function, specs[i].min_arity, specs[i].max_arity, specs[i].pure);
+}
+
+const NativeEntry *findNative(const std::string &name)
+{
+    auto found = native_functions.find(name);
+    return found != native_functions.end() ? &found->second : NULL;
+}
+
+bool acceptsArity(const NativeEntry *native, std::size_t count)
+{
+    return count >= (std::size_t)native->min_arity && (native->max_arity == VARIADIC || count <= (std::size_t)native->max_arity);
+}
+
+Object *nativeError(std::string message)
+{
+    Object *err = new Object();
+    err->which_object = ERROR_OBJ;
+    err->error_message = message;
+    return err;
+}
+
+static Object *builtinError(std::string message)
+{
+    return nativeError(message);
+}
+
+static Object *newArrayResult()
+{
+    Object *arr = new Object();
+    arr->which_object = ARRAY_OBJ;
+    return arr;
+}
+
+static Object *newIntegerResult(long value)
+{
+    return integerObject(value);
+}
+
+// an INTEGER when the value fits in a long
+static Object *newBigIntegerResult(const BigInteger &value)
+{
+    Object *obj = new Object();
+    setValBig(obj, value);
+    return obj;
+}
+
+static Object *newFloatResult(double value)
+{
+    return floatObject(value);
+}
+
+// booleans are compared by identity, natives hand back the shared true or false
+static Object *newBooleanResult(bool value)
+{
+    return boolObject(value);
+}
+
+static Object *newStringResult(std::string text)
+{
+    Object *obj = new Object();
+    obj->which_object = STRING_OBJ;
+    setValStr(obj, text);
+    return obj;
+}
+
+static Object *newVectorResult(PersistentVector vector)
+{
+    Object *result = new Object();
+    result->which_object = VECTOR_OBJ;
+    result->vector_trie = vector;
+    return result;
+}
+
+static Object *newMapResult(PersistentMap map)
+{
+    Object *result = new Object();
+    result->which_object = MAP_OBJ;
+    result->map_trie = map;
+    return result;
+}
+
+Object *builtinLenFunc(Object **arguments, std::size_t count)
+{
+    if(count != 1)
     {
-        std::cout << "verdiğin parametre sayisi 1 degil\n";
+        return builtinError("len needs one argument");
     }
     else
     {
         if(arguments[0]->which_object == STRING_OBJ)
         {
-            Object *lenFunc = new Object();
-            lenFunc->which_object = INTEGER_OBJ;
-            long size = sizeof((char *)arguments[0]->Value)/sizeof(char);
-            std::cout << "girdi buraya size: " << size << "\n";
-            setValLong(lenFunc, size );
-            
-            return *lenFunc;
+            // code points, counted when the string was made
+            return newIntegerResult((long)arguments[0]->str_chars);
         }
         else if(arguments[0]->which_object == ARRAY_OBJ)
         {
-            Object *lenFunc = new Object();
-            lenFunc->which_object = INTEGER_OBJ;
-            
-            long vallong = arguments[0]->elements.size();
-            setValLong(lenFunc, vallong);
-            return *lenFunc;
+            return newIntegerResult((long)arguments[0]->elements.length());
+        }
+        else if(arguments[0]->which_object == VECTOR_OBJ)
+        {
+            return newIntegerResult((long)arguments[0]->vector_trie.size());
+        }
+        else if(arguments[0]->which_object == MAP_OBJ)
+        {
+            return newIntegerResult((long)arguments[0]->map_trie.size());
         }
         else
         {
-            std::cout << "verdigin parametre string degil yapcagin isi sikeyim\n";
+            return builtinError("len needs a STRING, ARRAY, VECTOR or MAP, got " + arguments[0]->which_object);
         }
         
     }
 }
 
-Object builtinPushFunc(std::vector<Object *> arguments)
+// the boxed elements are allocated where they live as long as the array, and outside the lock since
+// allocating may take it
+static void unpackElements(Object *arr)
+{
+    MyMemory::Arena *arena = MyMemory::current;
+    if(!MyMemory::inArena(arr) || (arena != NULL && arena->outlivesIteration(arr)))
+        MyMemory::current = NULL;
+    MyMemory::limit_deferred = true;
+    std::vector<Object *> boxed = arr->elements.boxAll();
+    MyMemory::limit_deferred = false;
+    MyMemory::current = arena;
+
+    {
+        MyMemory::HeapLock guard(arr);
+        for(auto obj: boxed)
+            MyMemory::writeBarrier(arr, NULL, obj);
+        arr->elements.adopt(boxed);
+    }
+    MyMemory::reserveHeap(0);
+}
+
+// a slice gets storage of its own before it changes, the copy is made outside the lock like above
+static void detachView(Object *arr)
+{
+    ArrayStorage copy = arr->elements.materialized();
+    MyMemory::HeapLock guard(arr);
+    MyMemory::writeBarrier(arr, arr->elements.viewBase(), NULL);
+    copy.forEachObject([arr](Object *elem) { MyMemory::writeBarrier(arr, NULL, elem); });
+    arr->elements = std::move(copy);
+}
+
+// arrays that outlive the running loop iteration, or the arena, must not point into what it allocated
+static void pushElement(Object *arr, Object *elem)
+{
+    if(arr->elements.isView())
+        detachView(arr);
+    if(!arr->elements.fits(elem))
+        unpackElements(arr);
+    if(arr->elements.layout() != GENERIC_ARRAY)
+    {
+        // only the value is copied in, elem itself is not referenced and the marker never reads packed values
+        arr->elements.push(elem);
+        return;
+    }
+    elem = MyMemory::storable(arr, elem);
+    MyMemory::HeapLock guard(arr);
+    MyMemory::writeBarrier(arr, NULL, elem);
+    arr->elements.push(elem);
+}
+
+Object *builtinPushFunc(Object **arguments, std::size_t count)
 {
-    if(arguments.size() != 2)
+    // vectors are not changed, the pushed version is a new vector sharing all but its last nodes
+    if(count == 2 && arguments[0]->which_object == VECTOR_OBJ)
+    {
+        Object *element = arguments[1];
+        // a for-in loop variable is updated in place, the vector keeps a copy of its value
+        if(element->which_object == INTEGER_OBJ)
+        {
+            long value = (long)arguments[1]->Value;
+            element = new Object();
+            element->which_object = INTEGER_OBJ;
+            setValLong(element, value);
+        }
+        return newVectorResult(arguments[0]->vector_trie.push(element));
+    }
+    if(count != 2)
     {
-        std::cout << "verdigin parametre sayisi 2 degil(array ve eleman ver)\n";
+        return builtinError("push needs an array and an element");
     }
     else
     {
         if(arguments[0]->which_object != ARRAY_OBJ)
         {
-            std::cout << "verdigin ilk parametre array degil\n";
+            return builtinError("push needs an ARRAY or VECTOR, got " + arguments[0]->which_object);
         }
         else
         {
@@ -59,8 +221,8 @@ Object builtinPushFunc(std::vector<Object *> arguments)
                 Object *new_obj = new Object();
                 new_obj->which_object = STRING_OBJ;
 
-                setValStr(new_obj, (char *)arguments[1]->Value);
-                arguments[0]->elements.push_back(new_obj);
+                setValStr(new_obj, (char *)stringValue(arguments[1]));
+                pushElement(arguments[0], new_obj);
             }
             else if(arguments[1]->which_object == INTEGER_OBJ)
             {
@@ -69,14 +231,14 @@ Object builtinPushFunc(std::vector<Object *> arguments)
                 long arg = (long)arguments[1]->Value;
 
                 setValLong(new_obj, arg);
-                arguments[0]->elements.push_back(new_obj);
+                pushElement(arguments[0], new_obj);
             }
             else if(arguments[1]->which_object == ARRAY_OBJ)
             {
                 Object *new_obj = new Object();
                 new_obj->which_object = ARRAY_OBJ;
                 new_obj->elements = arguments[1]->elements;
-                arguments[0]->elements.push_back(new_obj);
+                pushElement(arguments[0], new_obj);
             }
             
             else if(arguments[1]->which_object == BOOLEAN_OBJ)
@@ -86,28 +248,35 @@ Object builtinPushFunc(std::vector<Object *> arguments)
 
                 bool arg = (long)arguments[1]->Value;
                 setValBool(new_obj, arg);
-                arguments[0]->elements.push_back(new_obj);
+                pushElement(arguments[0], new_obj);
 
             }
+            // immutable, so the array can share them instead of holding a copy
+            else if(arguments[1]->which_object == VECTOR_OBJ || arguments[1]->which_object == MAP_OBJ
+                    || arguments[1]->which_object == BIGINT_OBJ || arguments[1]->which_object == FLOAT_OBJ)
+            {
+                pushElement(arguments[0], arguments[1]);
+            }
             else
             {
-                std::cout << "verdigin 2. parametre ne kardes string array int yada bool degil\n";
+                return builtinError("can not push " + arguments[1]->which_object + " to an array");
             }
             
         }
         
     }
-    
+    return nullObject();
 }
 
-Object builtinPrintFunc(std::vector<Object *> arguments)
+Object *builtinPrintFunc(Object **arguments, std::size_t count)
 {
     
-    for(auto &arg: arguments)
+    for(std::size_t i = 0; i < count; i++)
     {
+        Object *arg = arguments[i];
         if(arg->which_object == STRING_OBJ)
         {
-            std::cout << (char *)arg->Value;
+            std::cout << stringValue(arg);
         }
         else if(arg->which_object == INTEGER_OBJ)
         {
@@ -123,10 +292,572 @@ Object builtinPrintFunc(std::vector<Object *> arguments)
         }
     }
     std::cout << "\n";
+    return nullObject();
+}
 
-    /*for(auto arg: arguments)
-        delete arg;
-    */
-    arguments.clear();
-    
-}
\ No newline at end of file
+static void setHashField(Object *hash, std::string key, long value)
+{
+    Object *key_obj = new Object();
+    key_obj->which_object = STRING_OBJ;
+    setValStr(key_obj, key);
+
+    Object *value_obj = new Object();
+    value_obj->which_object = INTEGER_OBJ;
+    setValLong(value_obj, value);
+
+    hash->HashPair.set(GetHashKey(key_obj), key_obj, value_obj);
+}
+
+Object *builtinHeapStatsFunc(Object **, std::size_t)
+{
+    MyMemory::HeapStats &stats = MyMemory::heapStats();
+    Object *result = new Object();
+    result->which_object = HASH_OBJ;
+    setHashField(result, "heap_bytes", stats.heap_bytes);
+    setHashField(result, "peak_heap_bytes", stats.peak_heap_bytes);
+    setHashField(result, "heap_limit", stats.heap_limit);
+    setHashField(result, "external_bytes", stats.external_bytes);
+    setHashField(result, "arena_bytes", MyMemory::current != NULL ? MyMemory::current->bytesUsed() : 0);
+    setHashField(result, "heap_blocks", stats.heap_blocks);
+    setHashField(result, "allocations", stats.allocations);
+    setHashField(result, "frees", stats.frees);
+    setHashField(result, "collections", stats.collections);
+    // whole microseconds, the percentile over the last PAUSE_WINDOW collections
+    setHashField(result, "pause_p99_us", (long)MyMemory::pausePercentile(99));
+    setHashField(result, "pause_max_us", (long)stats.max_pause_us);
+    return result;
+}
+
+// the elements of a generic array that are all numbers as packed doubles, false when one is not
+static bool packDoubles(ArrayStorage &elements, std::vector<std::int64_t> &bits, std::string &bad_type)
+{
+    bits.reserve(elements.length());
+    for(std::size_t i = 0; i < elements.length(); i++)
+    {
+        Object *elem = elements.get(i);
+        if(elem->which_object != INTEGER_OBJ && elem->which_object != FLOAT_OBJ)
+        {
+            bad_type = elem->which_object;
+            return false;
+        }
+        double value = numberValue(elem);
+        std::int64_t packed;
+        std::memcpy(&packed, &value, sizeof(double));
+        bits.push_back(packed);
+    }
+    return true;
+}
+
+// min and max take packed arrays straight to the kernels; generic arrays are checked element by
+// element, and go through the float kernel once integers and floats are mixed
+static Object *reduceNumbers(std::string name, Object **arguments, std::size_t count,
+                            std::int64_t (*kernel)(const std::int64_t *, std::size_t),
+                            double (*float_kernel)(const std::int64_t *, std::size_t))
+{
+    if(count != 1 || arguments[0]->which_object != ARRAY_OBJ)
+        return builtinError(name + " needs one array argument");
+    ArrayStorage &elements = arguments[0]->elements;
+    if(elements.layout() == BOOLEAN_ARRAY && elements.length() > 0)
+        return builtinError(name + " needs numbers, got " BOOLEAN_OBJ);
+    if(elements.length() == 0)
+        return builtinError(name + " of an empty array");
+    if(elements.layout() == FLOAT_ARRAY)
+        return newFloatResult(float_kernel(elements.packed(), elements.length()));
+    if(elements.layout() != GENERIC_ARRAY)
+        return newIntegerResult(kernel(elements.packed(), elements.length()));
+
+    std::vector<std::int64_t> values;
+    values.reserve(elements.length());
+    for(std::size_t i = 0; i < elements.length(); i++)
+    {
+        Object *elem = elements.get(i);
+        if(elem->which_object != INTEGER_OBJ)
+        {
+            std::vector<std::int64_t> bits;
+            std::string bad_type;
+            if(!packDoubles(elements, bits, bad_type))
+                return builtinError(name + " needs numbers, got " + bad_type);
+            return newFloatResult(float_kernel(bits.data(), bits.size()));
+        }
+        values.push_back((long)elem->Value);
+    }
+    return newIntegerResult(kernel(values.data(), values.size()));
+}
+
+// sums past the range of long, and sums with a BIGINT in them, come back as a BIGINT; a float
+// anywhere makes the sum a FLOAT
+Object *builtinSumFunc(Object **arguments, std::size_t count)
+{
+    if(count != 1 || arguments[0]->which_object != ARRAY_OBJ)
+        return builtinError("sum needs one array argument");
+    ArrayStorage &elements = arguments[0]->elements;
+    if(elements.layout() == BOOLEAN_ARRAY && elements.length() > 0)
+        return builtinError("sum needs numbers, got " BOOLEAN_OBJ);
+    if(elements.layout() == FLOAT_ARRAY)
+        return newFloatResult(sumFloat64(elements.packed(), elements.length()));
+    if(elements.layout() != GENERIC_ARRAY)
+        return newBigIntegerResult(bigFromInt128(sumInt64(elements.packed(), elements.length())));
+
+    __int128 small = 0;
+    BigInteger big;
+    double floats = 0;
+    bool any_float = false;
+    for(std::size_t i = 0; i < elements.length(); i++)
+    {
+        Object *elem = elements.get(i);
+        if(elem->which_object == INTEGER_OBJ)
+            small += (long)elem->Value;
+        else if(elem->which_object == BIGINT_OBJ)
+            big = bigAdd(big, bigValue(elem));
+        else if(elem->which_object == FLOAT_OBJ)
+        {
+            floats += doubleValue(elem);
+            any_float = true;
+        }
+        else
+            return builtinError("sum needs numbers, got " + elem->which_object);
+    }
+    BigInteger integers = bigAdd(big, bigFromInt128(small));
+    if(any_float)
+        return newFloatResult(floats + bigToDouble(integers));
+    return newBigIntegerResult(integers);
+}
+
+Object *builtinMinFunc(Object **arguments, std::size_t count)
+{
+    return reduceNumbers("min", arguments, count, &minInt64, &minFloat64);
+}
+
+Object *builtinMaxFunc(Object **arguments, std::size_t count)
+{
+    return reduceNumbers("max", arguments, count, &maxInt64, &maxFloat64);
+}
+
+// dot(a, b) of two arrays of numbers of the same length, always a FLOAT; packed float arrays are
+// multiplied in place, anything else is converted to doubles first
+Object *builtinDotFunc(Object **arguments, std::size_t count)
+{
+    if(count != 2 || arguments[0]->which_object != ARRAY_OBJ || arguments[1]->which_object != ARRAY_OBJ)
+        return builtinError("dot needs two arrays");
+    ArrayStorage &left = arguments[0]->elements, &right = arguments[1]->elements;
+    if(left.length() != right.length())
+        return builtinError("dot needs arrays of the same length");
+
+    std::vector<std::int64_t> left_bits, right_bits;
+    std::string bad_type;
+    const std::int64_t *left_values = left.packed(), *right_values = right.packed();
+    if(left.length() > 0 && left.layout() != FLOAT_ARRAY)
+    {
+        if(!packDoubles(left, left_bits, bad_type))
+            return builtinError("dot needs numbers, got " + bad_type);
+        left_values = left_bits.data();
+    }
+    if(right.length() > 0 && right.layout() != FLOAT_ARRAY)
+    {
+        if(!packDoubles(right, right_bits, bad_type))
+            return builtinError("dot needs numbers, got " + bad_type);
+        right_values = right_bits.data();
+    }
+    return newFloatResult(dotFloat64(left_values, right_values, left.length()));
+}
+
+static bool takesCallback(Object **arguments, std::size_t parameter_count)
+{
+    return arguments[0]->which_object == ARRAY_OBJ && arguments[1]->which_object == FUNCTION_OBJ
+           && arguments[1]->parameters.size() == parameter_count;
+}
+
+// callbacks are applied with one argument vector that is refilled for every element, and elements are
+// read by index each time since a callback may push to the array being walked
+Object *builtinMapFunc(Object **arguments, std::size_t count)
+{
+    if(count != 2 || !takesCallback(arguments, 1))
+        return builtinError("map needs an array and a function of one parameter");
+    Object *arr = arguments[0];
+    Object *fun = arguments[1];
+    std::size_t length = arr->elements.length();
+
+    std::vector<Object *> call_args(1);
+    std::vector<Object *> results;
+    results.reserve(length);
+    for(std::size_t i = 0; i < length; i++)
+    {
+        call_args[0] = arr->elements.get(i);
+        Object *result = applyFunction(fun, call_args);
+        if(isError(result))
+            return result;
+        results.push_back(result);
+    }
+    Object *mapped = newArrayResult();
+    mapped->elements.assign(results);
+    return mapped;
+}
+
+Object *builtinFilterFunc(Object **arguments, std::size_t count)
+{
+    if(count != 2 || !takesCallback(arguments, 1))
+        return builtinError("filter needs an array and a function of one parameter");
+    Object *arr = arguments[0];
+    Object *fun = arguments[1];
+    std::size_t length = arr->elements.length();
+
+    std::vector<Object *> call_args(1);
+    std::vector<Object *> kept;
+    for(std::size_t i = 0; i < length; i++)
+    {
+        call_args[0] = arr->elements.get(i);
+        Object *result = applyFunction(fun, call_args);
+        if(isError(result))
+            return result;
+        if(isTruthy(result))
+            kept.push_back(call_args[0]);
+    }
+    Object *filtered = newArrayResult();
+    filtered->elements.assign(kept);
+    return filtered;
+}
+
+// reduce(array, fn(acc, elem), initial), without an initial value the first element starts the fold
+Object *builtinReduceFunc(Object **arguments, std::size_t count)
+{
+    if((count != 2 && count != 3) || !takesCallback(arguments, 2))
+        return builtinError("reduce needs an array, a function of two parameters and an optional initial value");
+    Object *arr = arguments[0];
+    Object *fun = arguments[1];
+    std::size_t length = arr->elements.length();
+
+    std::size_t i = 0;
+    std::vector<Object *> call_args(2);
+    if(count == 3)
+        call_args[0] = arguments[2];
+    else if(length > 0)
+        call_args[0] = arr->elements.get(i++);
+    else
+        return builtinError("reduce of an empty array with no initial value");
+    for(; i < length; i++)
+    {
+        call_args[1] = arr->elements.get(i);
+        Object *result = applyFunction(fun, call_args);
+        if(isError(result))
+            return result;
+        call_args[0] = result;
+    }
+    // the accumulator itself, an array or hash passed in as the initial value keeps its identity
+    return call_args[0];
+}
+
+// range(end), range(start, end) or range(start, end, step); the error message, empty when the
+// arguments are fine and describe count integers from start on
+std::string rangeBounds(Object **arguments, std::size_t argument_count, long &start, long &step, std::size_t &count)
+{
+    if(argument_count == 0 || argument_count > 3)
+        return "range needs one to three integer arguments";
+    for(std::size_t i = 0; i < argument_count; i++)
+    {
+        if(arguments[i]->which_object != INTEGER_OBJ)
+            return "range needs integers, got " + arguments[i]->which_object;
+    }
+    start = argument_count == 1 ? 0 : (long)arguments[0]->Value;
+    long end = (long)arguments[argument_count == 1 ? 0 : 1]->Value;
+    step = argument_count == 3 ? (long)arguments[2]->Value : 1;
+    if(step == 0)
+        return "range step can not be 0";
+
+    count = 0;
+    if(step > 0 && start < end)
+        count = ((unsigned long)end - (unsigned long)start - 1) / (unsigned long)step + 1;
+    else if(step < 0 && start > end)
+        count = ((unsigned long)start - (unsigned long)end - 1) / (0UL - (unsigned long)step) + 1;
+    return "";
+}
+
+// always a packed integer array; a for-in loop over range() counts instead and builds none
+Object *builtinRangeFunc(Object **arguments, std::size_t count)
+{
+    long start, step;
+    std::size_t length;
+    std::string error = rangeBounds(arguments, count, start, step, length);
+    if(!error.empty())
+        return builtinError(error);
+
+    Object *range = newArrayResult();
+    std::int64_t *values = range->elements.assignPacked(INTEGER_ARRAY, length);
+    for(std::size_t i = 0; i < length; i++)
+        values[i] = (std::int64_t)((unsigned long)start + i * (unsigned long)step);
+    return range;
+}
+
+// vector(elem...), an immutable vector of the arguments
+Object *builtinVectorFunc(Object **arguments, std::size_t count)
+{
+    PersistentVector vector;
+    for(std::size_t i = 0; i < count; i++)
+        vector = vector.push(arguments[i]);
+    return newVectorResult(vector);
+}
+
+// hashmap(key, value, ...), an immutable map of the pairs
+Object *builtinHashmapFunc(Object **arguments, std::size_t count)
+{
+    if(count % 2 != 0)
+        return builtinError("hashmap needs keys and values in pairs");
+    PersistentMap map;
+    for(std::size_t i = 0; i < count; i += 2)
+    {
+        HashKeyClass hash_key = GetHashKey(arguments[i]);
+        if(hash_key.Type == NO_KEY)
+            return builtinError("unusable as hash key: " + arguments[i]->which_object);
+        map = map.set(hash_key, frozenKey(arguments[i]), arguments[i + 1]);
+    }
+    return newMapResult(map);
+}
+
+// set(vector, index, value) or set(map, key, value), a new collection with one slot replaced or added
+Object *builtinSetFunc(Object **arguments, std::size_t count)
+{
+    if(count != 3)
+        return builtinError("set needs a collection, a key and a value");
+    Object *coll = arguments[0];
+    if(coll->which_object == VECTOR_OBJ)
+    {
+        if(arguments[1]->which_object != INTEGER_OBJ)
+            return builtinError("vector index must be INTEGER, got " + arguments[1]->which_object);
+        long index = (long)arguments[1]->Value;
+        if(index < 0 || index > (long)coll->vector_trie.size())
+            return builtinError("vector index out of range: " + std::to_string(index));
+        return newVectorResult(coll->vector_trie.set(index, arguments[2]));
+    }
+    if(coll->which_object == MAP_OBJ)
+    {
+        HashKeyClass hash_key = GetHashKey(arguments[1]);
+        if(hash_key.Type == NO_KEY)
+            return builtinError("unusable as hash key: " + arguments[1]->which_object);
+        return newMapResult(coll->map_trie.set(hash_key, frozenKey(arguments[1]), arguments[2]));
+    }
+    return builtinError("set needs a VECTOR or MAP, got " + coll->which_object);
+}
+
+// substr(string, lo, hi) counted in code points; strings end at their terminator, so the range is copied out
+Object *builtinSubstrFunc(Object **arguments, std::size_t count)
+{
+    if(count != 3 || arguments[0]->which_object != STRING_OBJ
+       || arguments[1]->which_object != INTEGER_OBJ || arguments[2]->which_object != INTEGER_OBJ)
+        return builtinError("substr needs a string and two integer bounds");
+    Object *str = arguments[0];
+    long lo = (long)arguments[1]->Value;
+    long hi = (long)arguments[2]->Value;
+    if(lo < 0 || lo > hi || hi > (long)str->str_chars)
+        return builtinError("substr bounds out of range: [" + std::to_string(lo) + ":" + std::to_string(hi)
+                            + "] of length " + std::to_string(str->str_chars));
+
+    std::size_t first = charOffset(str, lo);
+    return newStringResult(std::string(stringValue(str) + first, charOffset(str, hi) - first));
+}
+
+// slice(array, lo, hi), a view sharing the array's storage; bounds are checked here and never again
+Object *builtinSliceFunc(Object **arguments, std::size_t count)
+{
+    if(count == 3 && arguments[0]->which_object == STRING_OBJ)
+        return builtinSubstrFunc(arguments, count);
+    if(count != 3 || arguments[0]->which_object != ARRAY_OBJ
+       || arguments[1]->which_object != INTEGER_OBJ || arguments[2]->which_object != INTEGER_OBJ)
+        return builtinError("slice needs an array and two integer bounds");
+    long length = arguments[0]->elements.length();
+    long lo = (long)arguments[1]->Value;
+    long hi = (long)arguments[2]->Value;
+    if(lo < 0 || lo > hi || hi > length)
+        return builtinError("slice bounds out of range: [" + std::to_string(lo) + ":" + std::to_string(hi)
+                            + "] of length " + std::to_string(length));
+
+    Object *view = newArrayResult();
+    view->elements.makeView(arguments[0], lo, hi - lo);
+    return view;
+}
+
+static bool stringArguments(Object **arguments, std::size_t count, std::size_t wanted)
+{
+    if(count != wanted)
+        return false;
+    for(std::size_t i = 0; i < count; i++)
+    {
+        if(arguments[i]->which_object != STRING_OBJ)
+            return false;
+    }
+    return true;
+}
+
+// find(string, part), the code point index of the first occurrence of part or -1
+Object *builtinFindFunc(Object **arguments, std::size_t count)
+{
+    if(!stringArguments(arguments, count, 2))
+        return builtinError("find needs two strings");
+    const char *text = stringValue(arguments[0]);
+    const char *found = findBytes(text, arguments[0]->str_length, stringValue(arguments[1]), arguments[1]->str_length);
+    if(found == NULL)
+        return newIntegerResult(-1);
+    std::size_t index = found - text;
+    if(arguments[0]->str_chars != arguments[0]->str_length)
+        scanUtf8(text, found - text, index);
+    return newIntegerResult((long)index);
+}
+
+Object *builtinContainsFunc(Object **arguments, std::size_t count)
+{
+    if(!stringArguments(arguments, count, 2))
+        return builtinError("contains needs two strings");
+    return newBooleanResult(findBytes(stringValue(arguments[0]), arguments[0]->str_length, stringValue(arguments[1]),
+                                      arguments[1]->str_length) != NULL);
+}
+
+Object *builtinStartsWithFunc(Object **arguments, std::size_t count)
+{
+    if(!stringArguments(arguments, count, 2))
+        return builtinError("starts_with needs two strings");
+    std::size_t length = arguments[1]->str_length;
+    return newBooleanResult(length <= arguments[0]->str_length
+                            && std::memcmp(stringValue(arguments[0]), stringValue(arguments[1]), length) == 0);
+}
+
+// split(string, separator); the pieces are counted first, so the array is allocated once at its final size
+Object *builtinSplitFunc(Object **arguments, std::size_t count)
+{
+    if(!stringArguments(arguments, count, 2) || arguments[1]->str_length == 0)
+        return builtinError("split needs a string and a non-empty separator");
+    const char *text = stringValue(arguments[0]);
+    const char *end = text + arguments[0]->str_length;
+    const char *separator = stringValue(arguments[1]);
+    std::size_t separator_length = arguments[1]->str_length;
+
+    std::size_t pieces_count = 1;
+    for(const char *at = text; (at = findBytes(at, end - at, separator, separator_length)) != NULL; at += separator_length)
+        pieces_count += 1;
+
+    std::vector<Object *> pieces;
+    pieces.reserve(pieces_count);
+    const char *start = text;
+    for(std::size_t i = 0; i < pieces_count; i++)
+    {
+        const char *stop = i + 1 < pieces_count ? findBytes(start, end - start, separator, separator_length) : end;
+        Object *piece = new Object();
+        piece->which_object = STRING_OBJ;
+        std::string part(start, stop - start);
+        setValStr(piece, part);
+        pieces.push_back(piece);
+        start = stop + separator_length;
+    }
+
+    Object *result = newArrayResult();
+    result->elements.assign(pieces);
+    return result;
+}
+
+// join(array of strings, separator), built in one buffer of the final length
+Object *builtinJoinFunc(Object **arguments, std::size_t count)
+{
+    if(count != 2 || arguments[0]->which_object != ARRAY_OBJ || arguments[1]->which_object != STRING_OBJ)
+        return builtinError("join needs an array of strings and a separator");
+    ArrayStorage &elements = arguments[0]->elements;
+    if(elements.length() > 0 && elements.layout() != GENERIC_ARRAY)
+        return builtinError("join needs an array of strings");
+
+    std::size_t length = 0;
+    for(std::size_t i = 0; i < elements.length(); i++)
+    {
+        if(elements.get(i)->which_object != STRING_OBJ)
+            return builtinError("join needs an array of strings, got " + elements.get(i)->which_object);
+        length += elements.get(i)->str_length + (i > 0 ? arguments[1]->str_length : 0);
+    }
+
+    std::string joined;
+    joined.reserve(length);
+    for(std::size_t i = 0; i < elements.length(); i++)
+    {
+        if(i > 0)
+            joined.append(stringValue(arguments[1]), arguments[1]->str_length);
+        joined.append(stringValue(elements.get(i)), elements.get(i)->str_length);
+    }
+    return newStringResult(joined);
+}
+
+// replace(string, old, new), every occurrence of old
+Object *builtinReplaceFunc(Object **arguments, std::size_t count)
+{
+    if(!stringArguments(arguments, count, 3) || arguments[1]->str_length == 0)
+        return builtinError("replace needs three strings, the second not empty");
+    const char *text = stringValue(arguments[0]);
+    const char *end = text + arguments[0]->str_length;
+    const char *old_text = stringValue(arguments[1]);
+    std::size_t old_length = arguments[1]->str_length;
+
+    std::string replaced;
+    replaced.reserve(arguments[0]->str_length);
+    const char *start = text;
+    for(const char *at; (at = findBytes(start, end - start, old_text, old_length)) != NULL; start = at + old_length)
+    {
+        replaced.append(start, at - start);
+        replaced.append(stringValue(arguments[2]), arguments[2]->str_length);
+    }
+    replaced.append(start, end - start);
+    return newStringResult(replaced);
+}
+
+// trim(string), without ASCII whitespace at either end
+Object *builtinTrimFunc(Object **arguments, std::size_t count)
+{
+    if(!stringArguments(arguments, count, 1))
+        return builtinError("trim needs a string");
+    const char *text = stringValue(arguments[0]);
+    std::size_t first = 0;
+    std::size_t last = arguments[0]->str_length;
+    while(first < last && std::isspace((unsigned char)text[first]))
+        first += 1;
+    while(last > first && std::isspace((unsigned char)text[last - 1]))
+        last -= 1;
+    return newStringResult(std::string(text + first, last - first));
+}
+
+// import_native(path), loads a native extension module; the functions it registers can be called
+// from the next line on, and from this one after the call
+Object *builtinImportNativeFunc(Object **arguments, std::size_t)
+{
+    if(arguments[0]->which_object != STRING_OBJ)
+        return builtinError("import_native needs the path of a shared object, got " + arguments[0]->which_object);
+    std::string error = loadNativeModule(stringValue(arguments[0]));
+    if(!error.empty())
+        return builtinError(error);
+    return nullObject();
+}
+
+static const NativeSpec core_builtins[] =
+{
+    {"len", &builtinLenFunc, 1, 1, true},
+    {"push", &builtinPushFunc, 2, 2, false},
+    {"print", &builtinPrintFunc, 0, VARIADIC, false},
+    {"heap_stats", &builtinHeapStatsFunc, 0, 0, false},
+    {"sum", &builtinSumFunc, 1, 1, true},
+    {"min", &builtinMinFunc, 1, 1, true},
+    {"max", &builtinMaxFunc, 1, 1, true},
+    {"dot", &builtinDotFunc, 2, 2, true},
+    {"map", &builtinMapFunc, 2, 2, false},
+    {"filter", &builtinFilterFunc, 2, 2, false},
+    {"reduce", &builtinReduceFunc, 2, 3, false},
+    {"range", &builtinRangeFunc, 1, 3, true},
+    {"vector", &builtinVectorFunc, 0, VARIADIC, true},
+    {"hashmap", &builtinHashmapFunc, 0, VARIADIC, true},
+    {"set", &builtinSetFunc, 3, 3, true},
+    {"slice", &builtinSliceFunc, 3, 3, true},
+    {"substr", &builtinSubstrFunc, 3, 3, true},
+    {"find", &builtinFindFunc, 2, 2, true},
+    {"contains", &builtinContainsFunc, 2, 2, true},
+    {"starts_with", &builtinStartsWithFunc, 2, 2, true},
+    {"split", &builtinSplitFunc, 2, 2, true},
+    {"join", &builtinJoinFunc, 2, 2, true},
+    {"replace", &builtinReplaceFunc, 3, 3, true},
+    {"trim", &builtinTrimFunc, 1, 1, true},
+    {"import_native", &builtinImportNativeFunc, 1, 1, false},
+};
+
+void registerBuiltins()
+{
+    registerNatives(core_builtins, sizeof(core_builtins) / sizeof(core_builtins[0]));
+}
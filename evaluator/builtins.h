@@ -2,15 +2,75 @@
 #define __BULTINS_HEADER__
 
 #include <unordered_map>
-#include <functional>
 #include "../object/object.h"
 
-extern std::unordered_map<std::string, std::function<Object(std::vector<Object *>)>> builtin_functions;
+// max_arity of a native taking any number of arguments from min_arity on
+#define VARIADIC -1
 
-void registerBuiltinFunctions(std::string func_name, std::function<Object(std::vector<Object *>)> function);
+// The calling convention of builtins and of functions a host registers. A native gets the evaluated
+// arguments as count pointers from arguments on, already checked against its arity, and returns its
+// result: an object it allocated, a shared one like nullObject() or boolObject(), or an ERROR_OBJ
+// from nativeError, which the script sees like any other error. NULL is taken as null.
+typedef Object *(*NativeFunction)(Object **arguments, std::size_t count);
 
-Object builtinLenFunc(std::vector<Object *> arguments);
-Object builtinPushFunc(std::vector<Object *> arguments);
-Object builtinPrintFunc(std::vector<Object *> arguments);
+struct NativeEntry
+{
+    NativeFunction function;
+    int min_arity;
+    int max_arity;
+    // no side effects and the result only depends on the arguments
+    bool pure;
+};
+
+// one row of a table of natives, for registering many at once
+struct NativeSpec
+{
+    const char *name;
+    NativeFunction function;
+    int min_arity;
+    int max_arity;
+    bool pure;
+};
+
+extern std::unordered_map<std::string, NativeEntry> native_functions;
+// bumped by every registration, a call site that looked its name up under an older one looks again
+extern unsigned long builtin_generation;
+
+// a later registration under the same name replaces the earlier one
+void registerNative(const std::string &name, NativeFunction function, int min_arity, int max_arity, bool pure);
+void registerNatives(const NativeSpec *specs, std::size_t count);
+// the builtins every script can call
+void registerBuiltins();
+// NULL when nothing is registered under name
+const NativeEntry *findNative(const std::string &name);
+bool acceptsArity(const NativeEntry *native, std::size_t count);
+Object *nativeError(std::string message);
+
+Object *builtinLenFunc(Object **arguments, std::size_t count);
+Object *builtinPushFunc(Object **arguments, std::size_t count);
+Object *builtinPrintFunc(Object **arguments, std::size_t count);
+Object *builtinHeapStatsFunc(Object **arguments, std::size_t count);
+Object *builtinSumFunc(Object **arguments, std::size_t count);
+Object *builtinMinFunc(Object **arguments, std::size_t count);
+Object *builtinMaxFunc(Object **arguments, std::size_t count);
+Object *builtinDotFunc(Object **arguments, std::size_t count);
+Object *builtinMapFunc(Object **arguments, std::size_t count);
+Object *builtinFilterFunc(Object **arguments, std::size_t count);
+Object *builtinReduceFunc(Object **arguments, std::size_t count);
+Object *builtinRangeFunc(Object **arguments, std::size_t count);
+std::string rangeBounds(Object **arguments, std::size_t argument_count, long &start, long &step, std::size_t &count);
+Object *builtinVectorFunc(Object **arguments, std::size_t count);
+Object *builtinHashmapFunc(Object **arguments, std::size_t count);
+Object *builtinSetFunc(Object **arguments, std::size_t count);
+Object *builtinSliceFunc(Object **arguments, std::size_t count);
+Object *builtinSubstrFunc(Object **arguments, std::size_t count);
+Object *builtinFindFunc(Object **arguments, std::size_t count);
+Object *builtinContainsFunc(Object **arguments, std::size_t count);
+Object *builtinStartsWithFunc(Object **arguments, std::size_t count);
+Object *builtinSplitFunc(Object **arguments, std::size_t count);
+Object *builtinJoinFunc(Object **arguments, std::size_t count);
+Object *builtinReplaceFunc(Object **arguments, std::size_t count);
+Object *builtinTrimFunc(Object **arguments, std::size_t count);
+Object *builtinImportNativeFunc(Object **arguments, std::size_t count);
 
 #endif
\ No newline at end of file
@@ -1,7 +1,18 @@
 #include "evaluator.h"
+#include "iterator.h"
+#include <climits>
+#include <memory>
+#include "../memory/heap.h"
 
-Object *boolean_obj = new Object();
-Object *null_obj = new Object();
+// preallocated, a line that ran out of heap has nowhere left to build its error
+Object *errorSingleton(std::string message)
+{
+    Object *obj = singletonObject(ERROR_OBJ, 0);
+    obj->error_message = message;
+    return obj;
+}
+
+Object *out_of_memory_obj = errorSingleton("out of memory: heap limit exceeded");
 
 bool isError(Object *obj)
 {
@@ -12,18 +23,24 @@ bool isError(Object *obj)
     return false;
 }
 
+// identifiers keep the hash of their name once it was needed
+static std::uint64_t nameHash(Node *identifier)
+{
+    if(identifier->Cache_name_hash == 0)
+        identifier->Cache_name_hash = MyEnv::hashName(identifier->Value);
+    return identifier->Cache_name_hash;
+}
+
 Object *boolObject(bool input)
 {
-    bool set = input;
-    
-    //boolean_obj->Value_bool = input;
-    setValBool(boolean_obj, input);
-    boolean_obj->which_object = BOOLEAN_OBJ;
-    return boolean_obj;
+    return input ? true_obj : false_obj;
 }
 
 bool isTruthy(Object *obj)
 {
+    // -0.0 has bits set but is as false as 0.0
+    if(obj->which_object == FLOAT_OBJ)
+        return doubleValue(obj) != 0;
     //if(obj->Value_bool)
     if((bool)obj->Value)
         return 1;
@@ -32,7 +49,6 @@ bool isTruthy(Object *obj)
 
 Object *nullObject()
 {
-    null_obj->which_object = NULL_OBJ;
     return null_obj;
 }
 
@@ -54,94 +70,159 @@ Object *evalBangOperatorExpression(Object *right)
 
 Object *evalMinusPrefixOperatorExpression(Object *right)
 {
+    if(right->which_object == FLOAT_OBJ)
+    {
+        return floatObject(-doubleValue(right));
+    }
+    if(right->which_object == BIGINT_OBJ || (right->which_object == INTEGER_OBJ && (long)right->Value == LONG_MIN))
+    {
+        Object *val = new Object();
+        setValBig(val, bigSubtract(BigInteger(), bigValue(right)));
+        return val;
+    }
     if(right->which_object != INTEGER_OBJ)
     {
         return newErrorPrefix("-",right->which_object);
     }
-    Object *val = new Object();
-    val->which_object = INTEGER_OBJ;
-    //val->Value_int = -right->Value_int;
     long right_value = (long)right->Value;
-    val->Value = (void *) -right_value;
-    return val;
+    return integerObject(-right_value);
 }
 
 Object *evalStringInfixExpression(std::string op, Object *left, Object *right)
 {
+    if(op == "==")
+        return boolObject(sameString(left, right));
+    if(op == "!=")
+        return boolObject(!sameString(left, right));
     if(op != "+")
     {
         return newErrorInfix(left->which_object, op, right->which_object);
     }
 
-    Object *str = new Object();
-    str->which_object = STRING_OBJ;
-    //str->Value_string = left->Value_string+right->Value_string;
-    std::string leftplusright = std::string((char*) left->Value) + std::string((char*) right->Value);
-    setValStr(str, leftplusright);
-    return str;
+    return concatStrings(left, right);
 }
 
-Object *evalIntegerInfixExpression(std::string op, Object *left, Object *right)
+Object *newErrorDivisionByZero()
 {
+    Object *err = new Object();
+    err->error_message = "division by zero";
+    err->which_object = ERROR_OBJ;
+    return err;
+}
 
-    Object *val = new Object();
-    val->which_object = INTEGER_OBJ;
-    long total_value;
+// arithmetic with a BIGINT on either side, or on two INTEGERs whose result did not fit in a long
+Object *evalBigIntegerInfixExpression(std::string op, Object *left, Object *right)
+{
+    BigInteger left_value = bigValue(left), right_value = bigValue(right);
+    BigInteger total_value;
     if(op == "+")
-    {
-        total_value = (long)left->Value + (long)right->Value;
-        setValLong(val, total_value);
-        return val;
-    }
+        total_value = bigAdd(left_value, right_value);
     else if(op == "-")
-    {
-        total_value = (long)left->Value - (long)right->Value;
-        setValLong(val, total_value);
-        return val;
-    }
+        total_value = bigSubtract(left_value, right_value);
     else if(op == "*")
-    {
-        total_value = (long)left->Value * (long)right->Value;
-        setValLong(val, total_value);
-        return val;
-    }
+        total_value = bigMultiply(left_value, right_value);
     else if(op == "/")
     {
-        total_value = (long)left->Value / (long)right->Value;
-        setValLong(val, total_value);
-        return val;
+        if(right_value.magnitude.empty())
+            return newErrorDivisionByZero();
+        total_value = bigDivide(left_value, right_value);
     }
     else if(op == "<")
-    {
-        delete val;
-        return boolObject((long)left->Value < (long)right->Value);
-    }
+        return boolObject(bigCompare(left_value, right_value) < 0);
     else if(op == "==")
-    {
-        delete val;
-        return boolObject((long)left->Value == (long)right->Value);
-    }
+        return boolObject(bigCompare(left_value, right_value) == 0);
     else if(op == "!=")
-    {
-        delete val;
-        return boolObject((long)left->Value != (long)right->Value);
-    }
+        return boolObject(bigCompare(left_value, right_value) != 0);
     else if(op == ">")
-    {
-        delete val;
-        return boolObject((long)left->Value > (long)right->Value);
-    }
+        return boolObject(bigCompare(left_value, right_value) > 0);
     else if(op == "<=")
-    {
-        delete val;
-        return boolObject((long)left->Value <= (long)right->Value);
-    }
+        return boolObject(bigCompare(left_value, right_value) <= 0);
     else if(op == ">=")
+        return boolObject(bigCompare(left_value, right_value) >= 0);
+    else
+        return newErrorInfix(left->which_object, op, right->which_object);
+
+    Object *val = new Object();
+    setValBig(val, total_value);
+    return val;
+}
+
+// a FLOAT on either side, the other number is converted; division by zero gives inf or nan
+Object *evalFloatInfixExpression(std::string op, Object *left, Object *right)
+{
+    double left_value = numberValue(left);
+    double right_value = numberValue(right);
+    double total_value;
+    if(op == "+")
+        total_value = left_value + right_value;
+    else if(op == "-")
+        total_value = left_value - right_value;
+    else if(op == "*")
+        total_value = left_value * right_value;
+    else if(op == "/")
+        total_value = left_value / right_value;
+    else if(op == "<")
+        return boolObject(left_value < right_value);
+    else if(op == "==")
+        return boolObject(left_value == right_value);
+    else if(op == "!=")
+        return boolObject(left_value != right_value);
+    else if(op == ">")
+        return boolObject(left_value > right_value);
+    else if(op == "<=")
+        return boolObject(left_value <= right_value);
+    else if(op == ">=")
+        return boolObject(left_value >= right_value);
+    else
+        return newErrorInfix(left->which_object, op, right->which_object);
+
+    return floatObject(total_value);
+}
+
+// the long fast path: a result that overflows is computed again as a BIGINT
+Object *evalIntegerInfixExpression(std::string op, Object *left, Object *right)
+{
+    long left_value = (long)left->Value;
+    long right_value = (long)right->Value;
+    long total_value;
+    bool overflow;
+    if(op == "+")
+        overflow = __builtin_add_overflow(left_value, right_value, &total_value);
+    else if(op == "-")
+        overflow = __builtin_sub_overflow(left_value, right_value, &total_value);
+    else if(op == "*")
+        overflow = __builtin_mul_overflow(left_value, right_value, &total_value);
+    else if(op == "/")
     {
-        delete val;
-        return boolObject((long)left->Value >= (long)right->Value);;
+        if(right_value == 0)
+            return newErrorDivisionByZero();
+        // LONG_MIN / -1 is the one quotient of two longs that is not a long
+        overflow = left_value == LONG_MIN && right_value == -1;
+        total_value = overflow ? 0 : left_value / right_value;
     }
-    return newErrorInfix(left->which_object, op, right->which_object);
+    else if(op == "<")
+        return boolObject(left_value < right_value);
+    else if(op == "==")
+        return boolObject(left_value == right_value);
+    else if(op == "!=")
+        return boolObject(left_value != right_value);
+    else if(op == ">")
+        return boolObject(left_value > right_value);
+    else if(op == "<=")
+        return boolObject(left_value <= right_value);
+    else if(op == ">=")
+        return boolObject(left_value >= right_value);
+    else
+        return newErrorInfix(left->which_object, op, right->which_object);
+
+    if(__builtin_expect(overflow, 0))
+        return evalBigIntegerInfixExpression(op, left, right);
+    return integerObject(total_value);
+}
+
+static bool isNumber(Object *obj)
+{
+    return obj->which_object == INTEGER_OBJ || obj->which_object == FLOAT_OBJ || obj->which_object == BIGINT_OBJ;
 }
 
 Object *evalInfixExpression(std::string op, Object *left, Object *right)
@@ -154,13 +235,22 @@ Object *evalInfixExpression(std::string op, Object *left, Object *right)
     {
         return evalStringInfixExpression(op, left, right);
     }
+    else if((left->which_object == INTEGER_OBJ || left->which_object == BIGINT_OBJ)
+            && (right->which_object == INTEGER_OBJ || right->which_object == BIGINT_OBJ))
+    {
+        return evalBigIntegerInfixExpression(op, left, right);
+    }
+    else if(isNumber(left) && isNumber(right))
+    {
+        return evalFloatInfixExpression(op, left, right);
+    }
     else if(op == "==")
     {
-        return boolObject(left == right); //this probably returns false all the time.
+        return boolObject(sameValue(left, right));
     }
     else if(op == "!=")
     {
-        return boolObject(left != right);//this probably returns false all the time.
+        return boolObject(!sameValue(left, right));
     }
     return newErrorInfix(left->which_object, op, right->which_object);
 }
@@ -181,64 +271,259 @@ Object *evalIfExpression(Node *if_expression, MyEnv::Env *env)
         return condition;
     if(isTruthy(condition))
     {
-        delete condition;
         return Eval(if_expression->Consequence_statement, env);
     }
     else if(if_expression->Alternative_statement != NULL)
     {
-        delete condition;
         return Eval(if_expression->Alternative_statement, env);
     }
     return nullObject();
 }
 
+// loops run to completion here, a break inside the body ends only the innermost loop
 Object *evalWhileExpression(Node *while_expression, MyEnv::Env *env)
 {
-    Object *condition = Eval(while_expression->Condition_identifier, env);
-    if(isError(condition))
-        return condition;
-    if(isTruthy(condition))
-    {
-        delete condition;
-        return Eval(while_expression->Consequence_statement, env);
+    MyMemory::LoopMark mark;
+    while(true)
+    {
+        Object *condition = Eval(while_expression->Condition_identifier, env);
+        if(isError(condition))
+            return condition;
+        if(!isTruthy(condition))
+            break;
+        Object *result = Eval(while_expression->Consequence_statement, env);
+        if(result->which_object == ERROR_OBJ || result->which_object == RETURN_VALUE_OBJ)
+            return result;
+        if(result->which_object == BREAK_OBJ)
+            break;
+        mark.nextIteration();
     }
-   
     return nullObject();
 }
 
+// The native a call names, or NULL when it names none or a binding of the script hides it. The
+// registry is searched once per site; after that a name no Env has ever bound needs no lookup at all.
+static const NativeEntry *nativeAt(Node *call, MyEnv::Env *env)
+{
+    Node *callee = call->Function_identifier;
+    if(callee->node_type != "Identifier" || callee->which_identifier != "")
+        return NULL;
+    if(call->Cache_generation != builtin_generation)
+    {
+        call->Cache_native = findNative(callee->Value);
+        call->Cache_generation = builtin_generation;
+        if(callee->Cache_name_hash == 0)
+            callee->Cache_name_hash = MyEnv::hashName(callee->Value);
+    }
+    if(call->Cache_native == NULL)
+        return NULL;
+    if(MyEnv::mayBeBound(callee->Cache_name_hash) && env->lookup(callee->Value, callee->Cache_name_hash) != NULL)
+        return NULL;
+    return call->Cache_native;
+}
 
-Object *evalProgram(Node *p, MyEnv::Env *env)
+static Object *newErrorArity(const std::string &name, const NativeEntry *native, std::size_t count)
 {
-    Object *result = new Object();
-    for(int i = 0; i < p->Node_array.size(); i++)
+    std::string wanted = std::to_string(native->min_arity);
+    if(native->max_arity == VARIADIC)
+        wanted = "at least " + wanted;
+    else if(native->max_arity != native->min_arity)
+        wanted += " to " + std::to_string(native->max_arity);
+    Object *err = new Object();
+    err->error_message = "wrong number of arguments to " + name + ": want " + wanted + ", got " + std::to_string(count);
+    err->which_object = ERROR_OBJ;
+    return err;
+}
+
+// Calls the native a CallExpression resolved to
+static Object *evalNativeCall(Node *call, const NativeEntry *native, MyEnv::Env *env)
+{
+    std::vector<Object *> args = evalExpressions(call->Node_array, env);
+    if(args.size() == 1 && isError(args[0]))
+        return args[0];
+    if(!acceptsArity(native, args.size()))
+        return newErrorArity(call->Function_identifier->Value, native, args.size());
+
+    MyMemory::ProfileSite frame(call, true);
+    Object *result = native->function(args.data(), args.size());
+    if(result == NULL)
+        return nullObject();
+    // booleans are compared by identity, a true or false a native made itself becomes the shared one
+    if(result->which_object == BOOLEAN_OBJ)
+        result = boolObject((bool)result->Value);
+    return result;
+}
+
+static bool isLoopVar(Node *node, const std::string &name)
+{
+    return node != NULL && node->node_type == "Identifier" && node->which_identifier == "" && node->Value == name;
+}
+
+// Whether the body may hold on to the loop variable's object past the step it was bound for, by
+// binding it to another name, storing it or returning it. Uses as an operand or an index only read
+// the value, and so do print, len and push, which copies integers into arrays and vectors alike.
+// Calls to user functions count as holding on, they may read the variable from an enclosing scope.
+static bool loopVarEscapes(Node *node, const std::string &name)
+{
+    if(node == NULL)
+        return false;
+    if(isLoopVar(node, name))
+        return true;
+
+    std::vector<Node *> children;
+    if(node->which_identifier == "FunctionLiteral")
+        return true;
+    if(node->which_identifier == "CallExpression")
+    {
+        std::string callee = node->Function_identifier->Value;
+        if(callee != "print" && callee != "len" && callee != "push")
+            return true;
+        // a function of the script's own by one of those names could keep it
+        if(MyEnv::mayBeBound(MyEnv::hashName(callee)))
+            return true;
+        for(auto arg: node->Node_array)
+        {
+            if(!isLoopVar(arg, name))
+                children.push_back(arg);
+        }
+    }
+    else if(node->which_identifier == "InfixExpression" || node->which_identifier == "PrefixExpression")
+    {
+        for(auto operand: {node->Left_identifier, node->Right_identifier})
+        {
+            if(!isLoopVar(operand, name))
+                children.push_back(operand);
+        }
+    }
+    else if(node->which_identifier == "IndexExpression")
+    {
+        for(auto operand: {node->Left_index, node->Index})
+        {
+            if(!isLoopVar(operand, name))
+                children.push_back(operand);
+        }
+    }
+    else
+    {
+        if(!isLoopVar(node->Condition_identifier, name))
+            children.push_back(node->Condition_identifier);
+        for(auto child: {node->Consequence_statement, node->Alternative_statement, node->Body_statement,
+                         node->Value_identifier, node->ReturnValue_identifier, node->Expression_identifier})
+            children.push_back(child);
+        for(auto child: node->Node_array)
+            children.push_back(child);
+        for(auto &vk: node->Pairs)
+        {
+            children.push_back(vk.first);
+            children.push_back(vk.second);
+        }
+    }
+    for(auto child: children)
+    {
+        if(loopVarEscapes(child, name))
+            return true;
+    }
+    return false;
+}
+
+// for (name in iterable) { body }. A range() call is counted out without building its array.
+// Integers are boxed into one object that is rebound once and then updated in place, unless the
+// body could keep it, or has rebound the name to something else meanwhile.
+Object *evalForExpression(Node *for_expression, MyEnv::Env *env)
+{
+    Node *iterable_node = for_expression->Value_identifier;
+    std::unique_ptr<Iterator> iterator;
+    if(iterable_node->which_identifier == "CallExpression" && iterable_node->Function_identifier->Value == "range"
+       && nativeAt(iterable_node, env) != NULL)
+    {
+        std::vector<Object *> args = evalExpressions(iterable_node->Node_array, env);
+        if(args.size() == 1 && isError(args[0]))
+            return args[0];
+        long start, step;
+        std::size_t count;
+        std::string error = rangeBounds(args.data(), args.size(), start, step, count);
+        if(!error.empty())
+        {
+            Object *err = new Object();
+            err->error_message = error;
+            err->which_object = ERROR_OBJ;
+            return err;
+        }
+        iterator.reset(new Iterator(start, step, count));
+    }
+    else
     {
-        if(p->Node_array[i]->which_statement == "WhileStatement")
+        Object *iterable = Eval(iterable_node, env);
+        if(isError(iterable))
+            return iterable;
+        if(!Iterator::iterable(iterable))
         {
-            while(1)
+            Object *err = new Object();
+            err->error_message = "not iterable: " + iterable->which_object;
+            err->which_object = ERROR_OBJ;
+            return err;
+        }
+        // an arena temporary keeps a heap iterable reachable even if the body rebinds its name
+        Object *anchor = new Object();
+        anchor->which_object = RETURN_VALUE_OBJ;
+        setValObj(anchor, iterable);
+        iterator.reset(new Iterator(iterable));
+    }
+
+    const std::string &name = for_expression->Name_identifier->Value;
+    bool reuse = !loopVarEscapes(for_expression->Body_statement, name);
+    Object *loop_var = NULL;
+    Object **slot = NULL;
+    Object *result = nullObject();
+    MyMemory::LoopMark mark;
+    while(!iterator->done())
+    {
+        long value;
+        Object *elem = iterator->next(value);
+        if(elem == NULL && loop_var != NULL && *slot == loop_var)
+        {
+            loop_var->Value = (void *)value;
+        }
+        else
+        {
+            bool boxed = elem == NULL;
+            if(boxed)
             {
-                if(result)
-                    delete result;
-                result = Eval(p->Node_array[i], env);
-                if(result->which_object == RETURN_VALUE_OBJ)
-                    return (Object *)result->Value;
-                if(result->which_object == ERROR_OBJ)
-                    return result;
-                if(result->which_object == BREAK_OBJ)
-                    break;
-                
+                elem = new Object();
+                elem->which_object = INTEGER_OBJ;
+                setValLong(elem, value);
             }
+            env->setObject(name, nameHash(for_expression->Name_identifier), elem, env);
+            // bindings stay where they are, the slot can be read without looking the name up again
+            slot = env->findSlot(name, nameHash(for_expression->Name_identifier));
+            // elements taken from a collection are shared with it and never written to
+            loop_var = reuse && boxed ? *slot : NULL;
         }
-        else
+
+        result = Eval(for_expression->Body_statement, env);
+        if(result->which_object == ERROR_OBJ || result->which_object == RETURN_VALUE_OBJ)
+            break;
+        if(result->which_object == BREAK_OBJ)
         {
-            delete result;
-            result = Eval(p->Node_array[i], env);
-            if(result->which_object == RETURN_VALUE_OBJ)
-                return (Object *)result->Value;
-            if(result->which_object == ERROR_OBJ)
-                return result;
-                
-            
+            result = nullObject();
+            break;
         }
+        result = nullObject();
+        mark.nextIteration();
+    }
+    return result;
+}
+
+Object *evalProgram(Node *p, MyEnv::Env *env)
+{
+    Object *result = new Object();
+    for(int i = 0; i < p->Node_array.size(); i++)
+    {
+        result = Eval(p->Node_array[i], env);
+        if(result->which_object == RETURN_VALUE_OBJ)
+            return (Object *)result->Value;
+        if(result->which_object == ERROR_OBJ)
+            return result;
     }
     return result;
 }
@@ -248,12 +533,9 @@ Object *evalBlockStatement(Node *p, MyEnv::Env *env)
     Object *result = new Object();
     for(int i = 0; i < p->Node_array.size(); i++)
     {
-        if(i < p->Node_array.size()-1)
-            delete result;
-        
         result = Eval(p->Node_array[i], env);
         std::string type = result->which_object;
-        if(type == ERROR_OBJ || type == RETURN_VALUE_OBJ)
+        if(type == ERROR_OBJ || type == RETURN_VALUE_OBJ || type == BREAK_OBJ)
             return result;
     }
     return result;
@@ -306,6 +588,14 @@ Object *newNoValueFoundError(std::string nodeType)
     return err;
 }
 
+Object *newErrorHashKey(std::string nodeType)
+{
+    Object *err = new Object();
+    err->error_message = "unusable as hash key: " + nodeType;
+    err->which_object = ERROR_OBJ;
+    return err;
+}
+
 Object *newErrorOutOfRange()
 {
     Object *err = new Object();
@@ -317,23 +607,38 @@ Object *newErrorOutOfRange()
 Object *evalArrayIndexExpression(Object *arr, Object *index)
 {
     long indx = (long)index->Value;
-    long max = arr->elements.size() -1;
+    long max = arr->elements.length() -1;
 
     if(indx < 0 || indx > max)
     {
-        Object *nullobj = new Object();
-        null_obj->which_object = NULL_OBJ;
-        return null_obj;
+        return nullObject();
     }
         
-    return arr->elements[indx];
+    return arr->elements.get(indx);
+}
+
+// the code point at index, as a string of its own
+Object *evalStringIndexExpression(Object *str, Object *index)
+{
+    long indx = (long)index->Value;
+    if(indx < 0 || indx >= (long)str->str_chars)
+    {
+        return nullObject();
+    }
+
+    std::size_t first = charOffset(str, indx);
+    std::size_t last = charOffset(str, indx + 1);
+    Object *character = new Object();
+    character->which_object = STRING_OBJ;
+    std::string text(stringValue(str) + first, last - first);
+    setValStr(character, text);
+    return character;
 }
 
 
 Object *evalHashLiteral(Node *node, MyEnv::Env *env)
 {
     Object *returnObj = new Object();
-    std::unordered_map<HashKeyClass, Object*, MyHashFunction> pairs;
     for(auto vk: node->Pairs)
     {
         Object *key = Eval(vk.first, env);
@@ -342,10 +647,12 @@ Object *evalHashLiteral(Node *node, MyEnv::Env *env)
             
             return key;
         }
-        if(key->which_object != STRING_OBJ && key->which_object != INTEGER_OBJ)
+        HashKeyClass hash_key = GetHashKey(key);
+        if(hash_key.Type == NO_KEY)
         {
-            std::cout << "unusabla as hash key !!! " << key->which_object << "\n";
+            return newErrorHashKey(key->which_object);
         }
+        key = frozenKey(key);
 
         Object *value = Eval(vk.second, env);
 
@@ -354,29 +661,30 @@ Object *evalHashLiteral(Node *node, MyEnv::Env *env)
             return value;
         }
 
-        Object *hash_pair = new Object();
-        hash_pair->Key = key;
-        hash_pair->which_object = value->which_object;
-        setValObj(hash_pair, value);
-        delete value;
-    
-        pairs[GetHashKey(key)] = hash_pair;
-
+        MyMemory::HeapLock guard(returnObj);
+        Object *old_value = returnObj->HashPair.set(hash_key, key, value);
+        if(old_value == NULL && returnObj->HashPair.layout() == NULL)
+            MyMemory::writeBarrier(returnObj, NULL, key);
+        MyMemory::writeBarrier(returnObj, old_value, value);
     }
     
-    returnObj->HashPair = pairs;
     returnObj->which_object = HASH_OBJ;
     return returnObj;
 }
 
 Object *evalHashIndexExpression(Object *left, Object* index)
 {
-    HashKeyClass get = GetHashKey(index);
-    if(left->HashPair[get])
+    HashKeyClass hash_key = GetHashKey(index);
+    if(hash_key.Type == NO_KEY)
     {
-        return (Object*) left->HashPair[get]->Value;
+        return newErrorHashKey(index->which_object);
     }
-    return newNoValueFoundError((char *)index->Value);
+    Object *found = left->HashPair.get(hash_key, index);
+    if(found != NULL)
+    {
+        return found;
+    }
+    return newNoValueFoundError(index->Inspect(index));
 }
 
 Object *evalIndexExpression(Object *left, Object *index)
@@ -389,48 +697,72 @@ Object *evalIndexExpression(Object *left, Object *index)
     {
         return evalHashIndexExpression(left, index);
     }
+    else if(left->which_object == STRING_OBJ && index->which_object == INTEGER_OBJ)
+    {
+        return evalStringIndexExpression(left, index);
+    }
+    else if(left->which_object == VECTOR_OBJ && index->which_object == INTEGER_OBJ)
+    {
+        long indx = (long)index->Value;
+        if(indx < 0 || indx >= (long)left->vector_trie.size())
+            return nullObject();
+        return left->vector_trie.get(indx);
+    }
+    else if(left->which_object == MAP_OBJ)
+    {
+        HashKeyClass hash_key = GetHashKey(index);
+        if(hash_key.Type == NO_KEY)
+            return newErrorHashKey(index->which_object);
+        Object *found = left->map_trie.get(hash_key, index);
+        if(found != NULL)
+            return found;
+        return newNoValueFoundError(index->Inspect(index));
+    }
 
     return newErrorIndex(left->which_object);
 }
 
 Object *evalIdentifier(Node *p, MyEnv::Env *env)
 {
-    if(!env->store[p->Value])
+    if(p->Cache_global < 0)
     {
-        if(builtin_functions[p->Value])
-        {
-            //std::vector<Object *> arg_array;
-            //arg_array.push_back(new Object());
-            //Object *returnObj = new Object(builtin_functions[p->Value](arg_array));
-            //return returnObj;
-        }
+        if(p->Cache_name_hash == 0)
+            p->Cache_name_hash = MyEnv::hashName(p->Value);
+        p->Cache_global = MyEnv::globalId(p->Value);
+    }
+    // the cached id stays right, only a local binding of the same name can make it the wrong one
+    if(p->Cache_global >= 0 && !MyEnv::mayBeShadowed(p->Cache_name_hash))
+    {
+        Object *global = env->root->getGlobal(p->Cache_global);
+        if(global != NULL)
+            return global;
     }
     return env->getObject(p->Value, env);
 }
 
-std::vector<Object *> evalExpressions(std::vector<Node *> args, MyEnv::Env *env)
+std::vector<Object *> evalExpressions(const std::vector<Node *> &args, MyEnv::Env *env)
 {
     std::vector<Object *> results;
-    Object *result = new Object();
+    Object *result = NULL;
     for(int i = 0; i < args.size(); i++)
     {
         result = Eval(args[i], env);
         if(isError(result))
         {
             results.clear();
-            //results.push_back(result);  //buraya bakilacak
+            results.push_back(result);
             return results;
         }
         results.push_back(result);
     }
     return results;
 }
-MyEnv::Env *extendedFunctionEnv(Object *fun, std::vector<Object *> args)
+MyEnv::Env *extendedFunctionEnv(Object *fun, const std::vector<Object *> &args)
 {
     MyEnv::Env *env = MyEnv::newEnclosedEnv(fun->env);
     for(int i = 0; i < fun->parameters.size(); i++)
     {
-        env->setObject(fun->parameters[i]->Value, args[i], env);
+        env->setObject(fun->parameters[i]->Value, nameHash(fun->parameters[i]), args[i], env);
     }
 
     return env;
@@ -438,26 +770,26 @@ MyEnv::Env *extendedFunctionEnv(Object *fun, std::vector<Object *> args)
 
 Object *unwrapReturnValue(Object *obj)
 {
-    if(obj->which_object == "ReturnValue")
+    if(obj->which_object == RETURN_VALUE_OBJ)
         return (Object *)obj->Value;
 
     return obj;
 }
 
-Object *applyFunction(Object *fun, std::vector<Object *> args)
+Object *applyFunction(Object *fun, const std::vector<Object *> &args)
 {
     if(fun->which_object == FUNCTION_OBJ)
     {
         MyEnv::Env *extendedEnv = extendedFunctionEnv(fun, args);
         Object *evaluated = Eval(fun->body, extendedEnv);
-        delete extendedEnv;
         return unwrapReturnValue(evaluated);
     }
     return newErrorFunction(fun->which_object);
 }
 
-Object *Eval(Node *p, MyEnv::Env *env)
+Object *evalNode(Node *p, MyEnv::Env *env)
 {
+    MyMemory::ProfileSite site(p);
     if(p->node_type == "Statement")
     {
         if(p->which_statement == "ExpressionStatement" || p->which_statement == "WhileStatement")
@@ -485,8 +817,8 @@ Object *Eval(Node *p, MyEnv::Env *env)
             Object *val = Eval(p->Value_identifier, env);
             if(isError(val))
                 return val;
-            env->setObject(p->Name_identifier->Value, val, env);
-            
+            env->setObject(p->Name_identifier->Value, nameHash(p->Name_identifier), val, env);
+            return nullObject();
         }
         else if(p->which_statement == "BreakStatement")
         {
@@ -521,12 +853,17 @@ Object *Eval(Node *p, MyEnv::Env *env)
         }
         else if(p->which_identifier == "IntegerLiteral")
         {
-            Object *integ = new Object();
-            long p_val = (long) p->Value_int;
-            setValLong(integ, p_val);
-            //integ->Value_int = p->Value_int;
-            integ->which_object = INTEGER_OBJ;
-            return integ;
+            if(!p->Value_string.empty())
+            {
+                Object *integ = new Object();
+                setValBig(integ, bigFromDecimal(p->Value_string));
+                return integ;
+            }
+            return integerObject((long)p->Value_int);
+        }
+        else if(p->which_identifier == "FloatLiteral")
+        {
+            return floatObject(p->Value_float);
         }
         else if(p->which_identifier == "Boolean")
         {
@@ -540,6 +877,10 @@ Object *Eval(Node *p, MyEnv::Env *env)
         {
             return evalWhileExpression(p, env);
         }
+        else if(p->which_identifier == "ForExpression")
+        {
+            return evalForExpression(p, env);
+        }
         else if(p->which_identifier == "FunctionLiteral")
         {
             Object *fun = new Object();
@@ -551,16 +892,9 @@ Object *Eval(Node *p, MyEnv::Env *env)
         }
         else if(p->which_identifier == "CallExpression")
         {
-            if(builtin_functions[p->Function_identifier->Value])
-            {
-                std::vector<Object *> args = evalExpressions(p->Node_array, env);
-                Object *returnObj = new Object(builtin_functions[p->Function_identifier->Value](args));
-                /*for(auto arg: args)
-                    delete arg;
-                args.clear();
-                */
-                return returnObj;
-            }
+            const NativeEntry *native = nativeAt(p, env);
+            if(native != NULL)
+                return evalNativeCall(p, native, env);
             Object *fun = Eval(p->Function_identifier, env);
             if(isError(fun))
                 return fun;
@@ -570,6 +904,7 @@ Object *Eval(Node *p, MyEnv::Env *env)
                 return args[0];
             }
 
+            MyMemory::ProfileSite frame(p, true);
             return applyFunction(fun, args);
         }
         else if(p->which_identifier == "StringLiteral")
@@ -585,7 +920,7 @@ Object *Eval(Node *p, MyEnv::Env *env)
             if(elements.size() == 1 && isError(elements[0]))
                 return elements[0];
             Object *arr = new Object();
-            arr->elements = elements;
+            arr->elements.assign(elements);
             arr->which_object = ARRAY_OBJ;
 
             return arr;
@@ -597,6 +932,13 @@ Object *Eval(Node *p, MyEnv::Env *env)
             {
                 return left;
             }
+            // a literal key into a record of the shape this site saw last is a single load
+            if(left->which_object == HASH_OBJ && p->Index->which_identifier == "StringLiteral")
+            {
+                Object *cached = left->HashPair.getCached(p->Index->Value_string, p->Cache_shape, p->Cache_slot);
+                if(cached != NULL)
+                    return cached;
+            }
             Object *index =  Eval(p->Index, env);
             if(isError(index))
             {
@@ -615,10 +957,29 @@ Object *Eval(Node *p, MyEnv::Env *env)
     }
     else if(p->node_type == "Program")
     {
-        return evalProgram(p, env);
+        // the line is abandoned where it ran out, its temporaries go with the arena
+        try
+        {
+            return evalProgram(p, env);
+        }
+        catch(MyMemory::HeapExhausted &)
+        {
+            return out_of_memory_obj;
+        }
     }
     else if(p->node_type == "Boolean")
     {
         return boolObject(p->Value_bool);
     }
+    return nullObject();
 }
+
+// A heap value handed back here may lose its binding before the caller is done with it, e.g. to a
+// let in the next element of the same array literal, so a collection later in the line must not free it.
+Object *Eval(Node *p, MyEnv::Env *env)
+{
+    Object *result = evalNode(p, env);
+    if(MyMemory::current != NULL)
+        MyMemory::current->hold(result);
+    return result;
+}
\ No newline at end of file
@@ -12,16 +12,23 @@ Object *nullObject();
 Object *evalBangOperatorExpression(Object *right);
 Object *evalMinusPrefixOperatorExpression(Object *right);
 Object *evalIntegerInfixExpression(std::string op, Object *left, Object *right);
+Object *evalBigIntegerInfixExpression(std::string op, Object *left, Object *right);
+Object *evalFloatInfixExpression(std::string op, Object *left, Object *right);
 Object *evalInfixExpression(std::string op, Object *left, Object *right);
 Object *evalPrefixExpression(std::string op, Object *right);
 Object *evalIfExpression(Node *if_expression, MyEnv::Env *env);
 Object *evalWhileExpression(Node *while_expression, MyEnv::Env *env);
+Object *evalForExpression(Node *for_expression, MyEnv::Env *env);
 Object *evalProgram(Node *p, MyEnv::Env *env);
 Object *evalBlockStatement(Node *p, MyEnv::Env *env);
+std::vector<Object *> evalExpressions(const std::vector<Node *> &args, MyEnv::Env *env);
 Object *evalHashLiteral(Node *p, MyEnv::Env *env);
 Object *evalHashIndexExpression(Object *left, Object* index);
+Object *evalStringIndexExpression(Object *str, Object *index);
 Object *newErrorInfix(std::string left, std::string operator_between, std::string right);
 Object *newErrorPrefix(std::string operator_between, std::string nodeType);
+// calls a user function, args must hold one object per parameter
+Object *applyFunction(Object *fun, const std::vector<Object *> &args);
 
 bool isError(Object *ob);
 bool isTruthy(Object *obj);
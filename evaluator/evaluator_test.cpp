@@ -3,6 +3,8 @@
 #include "../object/object.h"
 #include "../parser/parser.h"
 #include "evaluator.h"
+#include "builtins.h"
+#include "../memory/heap.h"
 
 
 bool testIntegerObject(Object *evaluated, int expected)
@@ -12,18 +14,18 @@ bool testIntegerObject(Object *evaluated, int expected)
         std::cout << "obj type is not integer, type is: " << evaluated->which_object << "\n";
         return false;
     }
-    if(evaluated->Value_int != expected)
+    if((long)evaluated->Value != expected)
     {
         if(evaluated->which_object == RETURN_VALUE_OBJ)
         {
-            if(evaluated->Value_object->Value_int != expected)
+            if((long)((Object *)evaluated->Value)->Value != expected)
             {
-                std::cout << "object has wrong value, got: " << evaluated->Value_object->Value_int<< " expected: " << expected << "\n";
+                std::cout << "object has wrong value, got: " << (long)((Object *)evaluated->Value)->Value<< " expected: " << expected << "\n";
                 return false;
             }
             return true;
         }
-        std::cout << "object has wrong value, got: " << evaluated->Value_int<< " expected: " << expected << "\n";
+        std::cout << "object has wrong value, got: " << (long)evaluated->Value<< " expected: " << expected << "\n";
         return false;
     }
     return true;
@@ -36,9 +38,9 @@ bool testBooleanObject(Object *evaluated, bool expected)
         std::cout << "obj type is not integer, type is: " << evaluated->which_object << "\n";
         return false;
     }
-    if(evaluated->Value_bool != expected)
+    if((bool)evaluated->Value != expected)
     {
-        std::cout << "Object has wrong value, got: " << evaluated->Value_bool << " expected: " << expected << "\n";
+        std::cout << "Object has wrong value, got: " << (bool)evaluated->Value << " expected: " << expected << "\n";
         return false;
     }
 
@@ -55,6 +57,20 @@ Object *testEval(std::string input, MyEnv::Env *env)
     return Eval(program, env);
 }
 
+// evaluates each input in env and compares what it prints as
+void testInspected(const std::vector<std::string> &tests, const std::vector<std::string> &expected_outputs, MyEnv::Env *env)
+{
+    for(int i = 0; i < tests.size(); i++)
+    {
+        Object *evaluated = testEval(tests[i], env);
+        std::string got = evaluated->Inspect(evaluated);
+        if(got != expected_outputs[i])
+        {
+            std::cout << tests[i] << " gave wrong value, got: " << got << " expected: " << expected_outputs[i] << "\n";
+        }
+    }
+}
+
 void TestEvalIntegerExpression(MyEnv::Env *env)
 {
     std::vector<std::string> tests = {"5","10","-5","-10","23","-32","5+5+5+5-10","2 * 2 * 2 * 2 * 2","-50 + 100 + -50","5 * 2 + 10","5 + 2 * 10", "20+2*10","20+2*-10","50/2*2+10","2*(5+10)","3*3*3+10","3*(3*3)+10","(5+10*2+15/3)*2+ -10"};
@@ -151,7 +167,238 @@ void TestFunctionObject(MyEnv::Env *env)
 
 }
 
+void TestForInLoop(MyEnv::Env *env)
+{
+    // pushing the loop variable keeps each step's value, like the equivalent while loop
+    std::vector<std::string> tests = {
+        "let a = vector(); for (i in range(0, 3)) { let a = push(a, i); } a",
+        "let vb = vector(); for (x in [10, 20, 30]) { let vb = push(vb, x); } vb",
+        "let arr = []; for (i in range(0, 3)) { push(arr, i); } arr",
+        "let s = 0; for (i in range(0, 5)) { let s = s + i; } s",
+        // the loop variable counts in an object of its own, not in the small integers results share
+        "let f = fn() { for (i in range(0, 5)) { let j = 2; } 2 }; f()",
+        "let g = fn() { for (k in [1, 2]) { for (i in range(0, 3)) { k } } 1 + 1 }; g()"};
+    std::vector<std::string> expected_outputs = {"[0,1,2]", "[10,20,30]", "[0,1,2]", "10", "2", "2"};
+    testInspected(tests, expected_outputs, env);
+}
+
+void TestArrayBuiltins(MyEnv::Env *env)
+{
+    std::vector<std::string> tests = {
+        "sum([1, 2, 3])", "min([4, 2, 9])", "max([4, 2, 9])",
+        "map([1, 2, 3], fn(x) { x * 2 })", "filter([1, 2, 3, 4], fn(x) { x > 2 })",
+        "reduce([1, 2, 3], fn(acc, x) { acc + x })", "reduce([1, 2, 3], fn(acc, x) { acc + x }, 10)",
+        // the initial value is the accumulator itself, not a copy of it
+        "let init = []; let r = reduce([1, 2], fn(acc, x) { push(acc, x); acc }, init); push(r, 3); init",
+        "range(4)", "range(1, 7, 2)", "reduce([], fn(acc, x) { acc })"};
+    std::vector<std::string> expected_outputs = {"6", "2", "9", "[2,4,6]", "[3,4]", "6", "16", "[1,2,3]",
+                                                 "[0,1,2,3]", "[1,3,5]", "reduce of an empty array with no initial value"};
+    testInspected(tests, expected_outputs, env);
+}
+
+void TestBigIntegers(MyEnv::Env *env)
+{
+    std::vector<std::string> tests = {
+        "9223372036854775807 + 1", "-9223372036854775807 - 1",
+        // LONG_MIN has no positive counterpart in a long
+        "let lm = -9223372036854775807 - 1; -lm", "lm / -1", "lm * -1",
+        "9223372036854775807 * 9223372036854775807",
+        // division truncates toward zero, for big and small integers alike
+        "-7 / 2", "7 / -2", "(9223372036854775807 * 4) / -3", "-(9223372036854775807 * 4) / 3",
+        // results that fit again are small integers, and equal to the same literal
+        "(9223372036854775807 + 1) - 1", "(9223372036854775807 + 1) == 9223372036854775808",
+        "sum([9223372036854775807, 1])"};
+    std::vector<std::string> expected_outputs = {
+        "9223372036854775808", "-9223372036854775808", "9223372036854775808", "9223372036854775808",
+        "9223372036854775808", "85070591730234615847396907784232501249", "-3", "-3",
+        "-12297829382473034409", "-12297829382473034409", "9223372036854775807", "1", "9223372036854775808"};
+    testInspected(tests, expected_outputs, env);
+}
+
+void TestFloats(MyEnv::Env *env)
+{
+    std::vector<std::string> tests = {
+        "2.5 + 1", "1 / 4.0", "0.1 + 0.2", "1.0 / 0", "2.0 * 3", "-0.0", "if (-0.0) { 1 } else { 2 }",
+        "3.0 == 3", "[1.5, 2.5]", "sum([1.5, 2.5])", "sum([1, 0.5])", "dot([1.0, 2.0], [3.0, 4.0])", "{1.5: 1}"};
+    std::vector<std::string> expected_outputs = {
+        "3.5", "0.25", "0.30000000000000004", "inf", "6.0", "-0.0", "2", "1", "[1.5,2.5]", "4.0", "1.5", "11.0",
+        "unusable as hash key: FLOAT"};
+    testInspected(tests, expected_outputs, env);
+}
+
+void TestHashShapes(MyEnv::Env *env)
+{
+    // one index site sees hashes of several shapes, and one past the shape layout's key limit
+    std::string wide = "{";
+    for(int i = 0; i < 40; i++)
+        wide += std::string(i > 0 ? ", " : "") + "\"k" + std::to_string(i) + "\": " + std::to_string(i);
+    wide += ", \"a\": 99}";
+    std::vector<std::string> tests = {
+        "let get = fn(h) { h[\"a\"] }; get({\"a\": 1})", "get({\"b\": 5, \"a\": 2})", "get({\"a\": 3})",
+        "get(" + wide + ")", "get({\"b\": 1})",
+        "let ra = {\"a\": 1, \"b\": 2}; let rb = {\"b\": 2, \"a\": 1}; rb[\"a\"]",
+        "{\"a\": 1, 2: \"x\", true: 3}", "{\"a\": 1, 2: \"x\", true: 3}[true]",
+        // keys made at run time: past the transitions one shape may have, the tables are dicts
+        "let letters = \"abcdefghijklmnopqrstuvwxyz\"; let hs = map(range(676), fn(i) { {letters[i / 26] + letters[i - i / 26 * 26]: i} }); hs[674][\"zy\"]",
+        "hs[3][\"ad\"]", "get({\"a\": 4})"};
+    std::vector<std::string> expected_outputs = {"1", "2", "3", "99", "Not settet key: a in map!", "1",
+                                                 "{a:1, 2:x, 1:3}", "3", "674", "3", "4"};
+    testInspected(tests, expected_outputs, env);
+}
+
+void TestStructuralEquality(MyEnv::Env *env)
+{
+    std::vector<std::string> tests = {
+        "[1, [2, 3]] == [1, [2, 3]]", "[1, 2] == [1, 3]", "\"ab\" == \"a\" + \"b\"", "{\"a\": [1]} == {\"a\": [1]}",
+        "{\"a\": 1, \"b\": 2} == {\"b\": 2, \"a\": 1}", "{[1, 2]: \"k\"}[[1, 2]]",
+        "let k = [1]; let h = {k: 1}; push(k, 2); h[[1]]", "h"};
+    std::vector<std::string> expected_outputs = {"1", "0", "1", "1", "1", "k", "1", "{[1]:1}"};
+    testInspected(tests, expected_outputs, env);
+}
+
+void TestUtf8Strings(MyEnv::Env *env)
+{
+    std::vector<std::string> tests = {
+        "len(\"h\xc3\xa9llo\")", "\"h\xc3\xa9llo\"[1]", "\"h\xc3\xa9llo\"[4]",
+        "len(\"\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\")", "\"\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\"[2]",
+        "substr(\"h\xc3\xa9llo\", 1, 3)"};
+    std::vector<std::string> expected_outputs = {"5", "\xc3\xa9", "o", "3", "\xe8\xaa\x9e", "\xc3\xa9l"};
+    testInspected(tests, expected_outputs, env);
+}
+
+void TestSlices(MyEnv::Env *env)
+{
+    std::vector<std::string> tests = {
+        "let arr = [1, 2, 3, 4, 5]; let s = slice(arr, 1, 4); s", "len(s)", "s[0]",
+        // pushing to a slice copies it out, the array it was cut from stays as it was
+        "push(s, 9); arr", "s"};
+    std::vector<std::string> expected_outputs = {"[2,3,4]", "3", "2", "[1,2,3,4,5]", "[2,3,4,9]"};
+    testInspected(tests, expected_outputs, env);
+}
+
+void TestStringBuiltins(MyEnv::Env *env)
+{
+    std::vector<std::string> tests = {
+        "find(\"hello\", \"ll\")", "find(\"hello\", \"z\")", "contains(\"hello\", \"ell\")",
+        "starts_with(\"hello\", \"he\")", "split(\"a,b,,c\", \",\")", "join([\"a\", \"b\", \"c\"], \"-\")",
+        "replace(\"aaa\", \"a\", \"bb\")", "trim(\"  hi  \")"};
+    std::vector<std::string> expected_outputs = {"2", "-1", "1", "1", "[a,b,,c]", "a-b-c", "bbbbbb", "hi"};
+    testInspected(tests, expected_outputs, env);
+}
+
+void TestPersistentCollections(MyEnv::Env *env)
+{
+    std::vector<std::string> tests = {
+        "let v = vector(1, 2, 3); let w = set(v, 1, 20); v", "w", "len(w)", "push(v, 4)", "v",
+        "let m = hashmap(\"a\", 1); let mm = set(m, \"b\", 2); m", "mm[\"b\"]", "mm == hashmap(\"b\", 2, \"a\", 1)"};
+    std::vector<std::string> expected_outputs = {"[1,2,3]", "[1,20,3]", "3", "[1,2,3,4]", "[1,2,3]", "{a:1}", "2", "1"};
+    testInspected(tests, expected_outputs, env);
+}
+
+// like testInspected, but each input runs as a REPL line does: in an arena that is reset after it, so
+// a collection the heap limit forces halfway through a line sees what the line is still holding
+void testInspectedLines(const std::vector<std::string> &tests, const std::vector<std::string> &expected_outputs, MyEnv::Env *env)
+{
+    MyMemory::Arena arena;
+    for(int i = 0; i < tests.size(); i++)
+    {
+        MyMemory::current = &arena;
+        Object *evaluated = testEval(tests[i], env);
+        std::string got = evaluated->Inspect(evaluated);
+        MyMemory::current = NULL;
+        arena.reset();
+        MyMemory::safepoint();
+        if(got != expected_outputs[i])
+        {
+            std::cout << tests[i] << " gave wrong value, got: " << got << " expected: " << expected_outputs[i] << "\n";
+        }
+    }
+    // no collection may still be under way when the tests evaluating outside an arena run
+    MyMemory::collect();
+}
+
+void TestHeapLimit(MyEnv::Env *env)
+{
+    MyMemory::setHeapLimit(1024 * 1024);
+    std::vector<std::string> tests = {"let big = range(1000000); 1", "1 + 1"};
+    std::vector<std::string> expected_outputs = {"out of memory: heap limit exceeded", "2"};
+    testInspectedLines(tests, expected_outputs, env);
+
+    // the old a is only held by the array literal being built when the let rebinds it
+    MyMemory::setHeapLimit(6000000);
+    tests = {"let a = range(300000); 1", "let b = [a, if (true) { let a = 0; let c = range(300000); 1 }];", "len(range(10))"};
+    expected_outputs = {"1", "out of memory: heap limit exceeded", "10"};
+    testInspectedLines(tests, expected_outputs, env);
+    MyMemory::setHeapLimit(0);
+}
+
+// loops hand back what each iteration allocated, so they run in a fixed arena; what an iteration gives
+// to something older than it still has to be there afterwards
+void TestLoopIterations(MyEnv::Env *env)
+{
+    std::vector<std::string> tests = {
+        "let f = fn() { let out = []; for (i in range(3)) { for (j in range(2)) { push(out, [i, j]) } }; out }; f()",
+        "let g = fn() { let last = 0; for (i in range(5)) { let last = fn() { i * 10 } }; last() }; g()",
+        "let h = fn() { let a = [1, 2]; let i = 0; while (i < 3) { push(a, \"x\"); let i = i + 1 }; a }; h()",
+        "let k = fn() { let s = \"\"; let i = 0; while (i < 3) { let s = s + \"ab\"; let i = i + 1 }; s }; k()",
+        "let l = fn() { let r = []; let i = 0; while (i < 3) { let r = [r, i]; let i = i + 1 }; r }; l()"};
+    std::vector<std::string> expected_outputs = {"[[0,0],[0,1],[1,0],[1,1],[2,0],[2,1]]", "40", "[1,2,x,x,x]", "ababab", "[[[[],0],1],2]"};
+    testInspectedLines(tests, expected_outputs, env);
+
+    MyMemory::setHeapLimit(8 * 1024 * 1024);
+    tests = {"let m = fn() { let i = 0; while (i < 100000) { let i = i + 1 }; i }; m()",
+             "let arr = []; let i = 0; while (i < 100000) { push(arr, i); let i = i + 1 }; len(arr)"};
+    expected_outputs = {"100000", "100000"};
+    testInspectedLines(tests, expected_outputs, env);
+    MyMemory::setHeapLimit(0);
+
+    // without a limit, what the iterations promoted is collected while the loop still runs
+    tests = {"let n = 0; while (n < 100000) { let n = n + 1 }; heap_stats()[\"peak_heap_bytes\"] < 16000000"};
+    expected_outputs = {"1"};
+    testInspectedLines(tests, expected_outputs, env);
+}
+
+// interned text is dropped once no string uses it, the intern table does not keep it alive
+void TestInternedStrings(MyEnv::Env *env)
+{
+    MyMemory::collect();
+    std::size_t before = MyMemory::heapStats().heap_bytes;
+    std::vector<std::string> tests = {
+        "let letters = \"abcdefghijklmnopqrstuvwxyz\"; for (i in range(26)) { for (j in range(26)) { for (k in range(26)) { let s = letters[i] + letters[j] + letters[k] } } }; letters[25] + letters[0]"};
+    std::vector<std::string> expected_outputs = {"za"};
+    testInspectedLines(tests, expected_outputs, env);
+    std::size_t after = MyMemory::heapStats().heap_bytes;
+    if(after > before + 64 * 1024)
+        std::cout << "interned strings were kept alive, the heap grew by " << after - before << " bytes\n";
+}
+
+void TestImportNative(MyEnv::Env *env)
+{
+    std::vector<std::string> tests = {"import_native(\"/nonexistent/libnope.so\")", "import_native(1)"};
+    std::vector<std::string> expected_outputs = {
+        "can not load native module /nonexistent/libnope.so: /nonexistent/libnope.so: cannot open shared object file: No such file or directory",
+        "import_native needs the path of a shared object, got INTEGER"};
+    testInspected(tests, expected_outputs, env);
+}
+
 int main()
 {
+    registerBuiltins();
+    // first: the other tests evaluate outside an arena, nothing counts the references their heap
+    // objects are built with, and a collection must not meet those
+    TestHeapLimit(MyMemory::pin(MyEnv::newEnv()));
+    TestLoopIterations(MyMemory::pin(MyEnv::newEnv()));
+    TestInternedStrings(MyMemory::pin(MyEnv::newEnv()));
     TestFunctionObject(MyEnv::newEnv());
+    TestForInLoop(MyEnv::newEnv());
+    TestArrayBuiltins(MyEnv::newEnv());
+    TestBigIntegers(MyEnv::newEnv());
+    TestFloats(MyEnv::newEnv());
+    TestHashShapes(MyEnv::newEnv());
+    TestStructuralEquality(MyEnv::newEnv());
+    TestUtf8Strings(MyEnv::newEnv());
+    TestSlices(MyEnv::newEnv());
+    TestStringBuiltins(MyEnv::newEnv());
+    TestPersistentCollections(MyEnv::newEnv());
+    TestImportNative(MyEnv::newEnv());
 }
\ No newline at end of file
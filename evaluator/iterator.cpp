@@ -0,0 +1,100 @@
+#include "iterator.h"
+#include "../object/utf8.h"
+
+Iterator::Iterator(long first, long stride, std::size_t length)
+{
+    kind = RANGE_ITERATOR;
+    source = NULL;
+    start = first;
+    step = stride;
+    position = 0;
+    offset = 0;
+    count = length;
+}
+
+Iterator::Iterator(Object *iterable)
+{
+    source = iterable;
+    start = 0;
+    step = 1;
+    position = 0;
+    offset = 0;
+    count = 0;
+    if(iterable->which_object == ARRAY_OBJ)
+    {
+        kind = ARRAY_ITERATOR;
+        count = iterable->elements.length();
+    }
+    else if(iterable->which_object == VECTOR_OBJ)
+    {
+        kind = VECTOR_ITERATOR;
+        count = iterable->vector_trie.size();
+    }
+    else if(iterable->which_object == STRING_OBJ)
+    {
+        kind = STRING_ITERATOR;
+        count = iterable->str_chars;
+    }
+    else if(iterable->which_object == HASH_OBJ)
+    {
+        kind = HASH_ITERATOR;
+        count = iterable->HashPair.size();
+    }
+    else
+    {
+        kind = MAP_ITERATOR;
+        iterable->map_trie.forEachEntry([this](const HashTable::Entry &entry) { keys.push_back(entry.key); });
+        count = keys.size();
+    }
+}
+
+bool Iterator::iterable(Object *obj)
+{
+    return obj->which_object == ARRAY_OBJ || obj->which_object == VECTOR_OBJ || obj->which_object == STRING_OBJ
+           || obj->which_object == HASH_OBJ || obj->which_object == MAP_OBJ;
+}
+
+static Object *newString(std::string str)
+{
+    Object *obj = new Object();
+    obj->which_object = STRING_OBJ;
+    setValStr(obj, str);
+    return obj;
+}
+
+Object *Iterator::next(long &value)
+{
+    std::size_t i = position++;
+    if(kind == RANGE_ITERATOR)
+    {
+        value = (long)((unsigned long)start + i * (unsigned long)step);
+        return NULL;
+    }
+    if(kind == ARRAY_ITERATOR)
+    {
+        // the layout is looked up every time, the loop body may have unpacked the array
+        if(source->elements.layout() == INTEGER_ARRAY)
+        {
+            value = (long)source->elements.packed()[i];
+            return NULL;
+        }
+        return source->elements.get(i);
+    }
+    if(kind == VECTOR_ITERATOR)
+        return source->vector_trie.get(i);
+    if(kind == STRING_ITERATOR)
+    {
+        // text that is not UTF-8 is walked a byte at a time, like it is indexed
+        const char *text = stringValue(source) + offset;
+        std::size_t length = source->str_bytes ? 1 : utf8SequenceLength((unsigned char)text[0]);
+        offset += length;
+        return newString(std::string(text, length));
+    }
+    if(kind == HASH_ITERATOR)
+    {
+        const std::string *name = NULL;
+        Object *key = source->HashPair.keyAt(i, name);
+        return key != NULL ? key : newString(*name);
+    }
+    return keys[i];
+}
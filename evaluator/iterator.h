@@ -0,0 +1,38 @@
+#ifndef __ITERATOR_HEADER__
+#define __ITERATOR_HEADER__
+
+#include <cstddef>
+#include <vector>
+#include "../object/object.h"
+
+enum IteratorKind { RANGE_ITERATOR, ARRAY_ITERATOR, VECTOR_ITERATOR, STRING_ITERATOR, HASH_ITERATOR, MAP_ITERATOR };
+
+// What a for-in loop walks. A range is counted out without building an array; arrays and vectors are
+// read by position, strings a code point at a time, and hashes and maps yield their keys. The number of elements is fixed
+// when the loop starts, elements pushed while it runs are not visited.
+class Iterator
+{
+    public:
+        Iterator(long start, long step, std::size_t count);
+        explicit Iterator(Object *iterable);
+
+        static bool iterable(Object *obj);
+        bool done() const { return position >= count; }
+        // the next element; integers of a range or a packed array are not boxed, they come back in
+        // value with NULL returned for the caller to decide where to put them
+        Object *next(long &value);
+
+    private:
+        IteratorKind kind;
+        Object *source;
+        long start;
+        long step;
+        std::size_t position;
+        std::size_t count;
+        // strings: the byte the next code point starts at
+        std::size_t offset;
+        // a map has no positions, its keys are collected when the loop starts
+        std::vector<Object *> keys;
+};
+
+#endif
@@ -0,0 +1,58 @@
+#include "../native/native_api.h"
+#include <stdint.h>
+
+// gcc -O2 -shared -fPIC -o libhash.so extensions/hash_module.c
+// then in a script: import_native("./libhash.so"); fnv_hash("abc")
+// script identifiers can not hold digits, the functions are registered as fnv_hash and crc_hash
+
+static const NativeHost *host;
+static uint32_t crc_table[256];
+
+// fnv_hash(string), the 64-bit FNV-1a hash of the bytes
+static NativeValue *fnv1a(NativeValue **arguments, size_t count)
+{
+    // the host has checked the arity
+    (void)count;
+    size_t length;
+    const char *data = host->string_data(arguments[0], &length);
+    if(data == NULL)
+        return host->new_error("fnv_hash needs a string");
+    uint64_t hash = 14695981039346656037ull;
+    for(size_t i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ull;
+    }
+    return host->new_integer((long long)hash);
+}
+
+// crc_hash(string), the CRC-32 of zlib and PNG
+static NativeValue *crc32(NativeValue **arguments, size_t count)
+{
+    (void)count;
+    size_t length;
+    const char *data = host->string_data(arguments[0], &length);
+    if(data == NULL)
+        return host->new_error("crc_hash needs a string");
+    uint32_t crc = 0xffffffffu;
+    for(size_t i = 0; i < length; i++)
+        crc = crc_table[(crc ^ (unsigned char)data[i]) & 0xff] ^ (crc >> 8);
+    return host->new_integer(crc ^ 0xffffffffu);
+}
+
+NATIVE_MODULE_INIT(native_host)
+{
+    if(native_host->api_version < 1)
+        return 1;
+    host = native_host;
+    for(uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for(int bit = 0; bit < 8; bit++)
+            crc = crc & 1 ? 0xedb88320u ^ (crc >> 1) : crc >> 1;
+        crc_table[i] = crc;
+    }
+    if(host->register_function("fnv_hash", &fnv1a, 1, 1, 1) != 0)
+        return 2;
+    return host->register_function("crc_hash", &crc32, 1, 1, 1) != 0 ? 3 : 0;
+}
@@ -1,15 +1,21 @@
 #include "lexer.h"
 
-Lexer *New(std::string input)
+Lexer *New(std::string input, int line)
 {
     Lexer *l = new Lexer();
     l->input = input;
+    l->line = line;
     readChar(l);
     return l;
 } 
 
 void readChar(Lexer *l)
 {
+    if(l->ch == '\n')
+    {
+        l->line += 1;
+        l->lineStart = l->readPosition;
+    }
     if(l->readPosition >= l->input.size()){
         l->ch = 0;
     }
@@ -37,7 +43,8 @@ Token nextToken(Lexer *l)
     struct Token tok;
 
     skipWhitespace(l);
-    
+    int line = l->line;
+    int column = l->position - l->lineStart + 1;
 
     switch(l->ch)
     {
@@ -134,12 +141,16 @@ Token nextToken(Lexer *l)
             {
                 tok.Literal = readIdentifier(l);
                 tok.Type = LookupIdent(tok.Literal);
+                tok.Line = line;
+                tok.Column = column;
                 return tok;
             }
             else if(isDigit(l->ch))
             {
-                tok.Type = INT;
                 tok.Literal = readNumber(l);
+                tok.Type = tok.Literal.find_first_of(".eE") == std::string::npos ? INT : FLOAT;
+                tok.Line = line;
+                tok.Column = column;
                 return tok;
             }
             else
@@ -149,9 +160,12 @@ Token nextToken(Lexer *l)
     }
 
     readChar(l);
+    tok.Line = line;
+    tok.Column = column;
     return tok;
 }
 
+// digits, then a fraction and an exponent when digits follow them: 2.5, 1e9, 6.02e-23
 std::string readNumber(Lexer *l)
 {
     int position = l->position;
@@ -159,6 +173,25 @@ std::string readNumber(Lexer *l)
     {
         readChar(l);
     }
+    if(l->ch == '.' && isDigit(peekChar(l)))
+    {
+        readChar(l);
+        while(isDigit(l->ch))
+            readChar(l);
+    }
+    if(l->ch == 'e' || l->ch == 'E')
+    {
+        std::size_t digit = l->readPosition;
+        if(digit < l->input.size() && (l->input[digit] == '+' || l->input[digit] == '-'))
+            digit += 1;
+        if(digit < l->input.size() && isDigit(l->input[digit]))
+        {
+            while(l->readPosition <= digit)
+                readChar(l);
+            while(isDigit(l->ch))
+                readChar(l);
+        }
+    }
     return l->input.substr(position, l->position-position);
 }
 
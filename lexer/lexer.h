@@ -10,6 +10,8 @@ struct Lexer{
     int position;
     int readPosition;
     char ch;
+    int line;
+    int lineStart;
 };
 
 
@@ -19,7 +21,7 @@ std::string readIdentifier(Lexer *l);
 bool isDigit(char ch);
 std::string readNumber(Lexer *l);
 void skipWhitespace(Lexer *l);
-Lexer *New(std::string input);
+Lexer *New(std::string input, int line = 1);
 void readChar(Lexer *l);
 Token nextToken(Lexer *l);
 
@@ -81,7 +81,7 @@ void TestString()
 
     statement->Value_identifier = identifier2;
 
-    program->Statements_program.push_back(statement);
+    program->Node_array.push_back(statement);
 
     std::cout << "program.string: \n\n" << program->String() << "\n";
 }
@@ -114,19 +114,19 @@ void TestIdentifierExpression()
     {
         std::cout << "null bu\n";
     }
-    if(program->Statements_program.size() != 1 )
-        std::cout << "program statements does not contains 1 statements!!!!" << " " << program->Statements_program.size();
+    if(program->Node_array.size() != 1 )
+        std::cout << "program statements does not contains 1 statements!!!!" << " " << program->Node_array.size();
 
 
-    //if(program->Statements_program[0]->Expression_identifier->TokenLiteral() != "foobar")
-    if(program->Statements_program[0]->Expression_identifier->TokenLiteral() != "foobar")
+    //if(program->Node_array[0]->Expression_identifier->TokenLiteral() != "foobar")
+    if(program->Node_array[0]->Expression_identifier->TokenLiteral() != "foobar")
     {
-        std::cout << "ident is not foobar. "<< program->Statements_program[0]->TokenLiteral() << "\n";
+        std::cout << "ident is not foobar. "<< program->Node_array[0]->TokenLiteral() << "\n";
     }
 
-    if(program->Statements_program[0]->Expression_identifier->Value != "foobar")
+    if(program->Node_array[0]->Expression_identifier->Value != "foobar")
     {
-        std::cout << "ident.value is not foobar.: " << program->Statements_program[0]->Expression_identifier->Value << "\n";
+        std::cout << "ident.value is not foobar.: " << program->Node_array[0]->Expression_identifier->Value << "\n";
     }
     
 }
@@ -156,16 +156,93 @@ void TestIntegerLiteralExpression()
     {
         std::cout << "null bu\n";
     }
-    if(program->Statements_program.size() != 1 )
-        std::cout << "program statements does not contains 1 statements!!!!" << " " << program->Statements_program.size();
+    if(program->Node_array.size() != 1 )
+        std::cout << "program statements does not contains 1 statements!!!!" << " " << program->Node_array.size();
 
-    if(program->Statements_program[0]->Expression_identifier->Value_int != 5)
+    if(program->Node_array[0]->Expression_identifier->Value_int != 5)
     {
-        std::cout <<" some error occured value is not 5: "<< program->Statements_program[0]->Expression_identifier->Value_int << "\n";
+        std::cout <<" some error occured value is not 5: "<< program->Node_array[0]->Expression_identifier->Value_int << "\n";
     }
-    if(program->Statements_program[0]->Expression_identifier->TokenLiteral() != "5")
+    if(program->Node_array[0]->Expression_identifier->TokenLiteral() != "5")
     {
-        std::cout <<" some error occured literal is not 5: "<< program->Statements_program[0]->Expression_identifier->Value_int << "\n";
+        std::cout <<" some error occured literal is not 5: "<< program->Node_array[0]->Expression_identifier->Value_int << "\n";
+    }
+}
+
+void TestFloatLiteralTokens()
+{
+    // a fraction needs digits on both sides of the dot, an exponent needs digits after the e
+    std::vector<std::string> inputs = {"1.5", "1e3", "1.5e-2", "2.", ".5", "1e"};
+    std::vector<std::vector<std::string>> expected_types = {
+        {FLOAT}, {FLOAT}, {FLOAT}, {INT, ILLEGAL}, {ILLEGAL, INT}, {INT, IDENT}};
+    std::vector<std::string> expected_first = {"1.5", "1e3", "1.5e-2", "2", ".", "1"};
+
+    for(int i = 0; i < inputs.size(); i++)
+    {
+        Lexer *l = New(inputs[i]);
+        std::vector<Token> tokens;
+        for(Token tok = nextToken(l); tok.Type != END_OF_FILE; tok = nextToken(l))
+            tokens.push_back(tok);
+        if(tokens.size() != expected_types[i].size())
+        {
+            std::cout << inputs[i] << " lexed into " << tokens.size() << " tokens, expected " << expected_types[i].size() << "\n";
+            continue;
+        }
+        for(int j = 0; j < tokens.size(); j++)
+        {
+            if(tokens[j].Type != expected_types[i][j])
+                std::cout << inputs[i] << " token " << j << " is " << tokens[j].Type << ", expected " << expected_types[i][j] << "\n";
+        }
+        if(expected_types[i][0] != ILLEGAL && tokens[0].Literal != expected_first[i])
+            std::cout << inputs[i] << " first literal is " << tokens[0].Literal << ", expected " << expected_first[i] << "\n";
+    }
+}
+
+void TestFloatLiteralExpression()
+{
+    std::vector<std::string> inputs = {"1.5;", "1e3;", "6.02e-23;"};
+    std::vector<double> expected_values = {1.5, 1000, 6.02e-23};
+
+    for(int i = 0; i < inputs.size(); i++)
+    {
+        Lexer *l = New(inputs[i]);
+        Parser *p = New(l);
+
+        Node *program = ParseProgram(p);
+        checkParserErrors(p);
+        Node *literal = program->Node_array[0]->Expression_identifier;
+        if(literal->which_identifier != "FloatLiteral")
+            std::cout << inputs[i] << " is not a FloatLiteral, it is: " << literal->which_identifier << "\n";
+        if(literal->Value_float != expected_values[i])
+            std::cout << inputs[i] << " has value " << literal->Value_float << ", expected " << expected_values[i] << "\n";
+    }
+
+    // neither is a number, the stray dot is a parse error
+    for(std::string input: {"2.;", ".5;"})
+    {
+        Lexer *l = New(input);
+        Parser *p = New(l);
+        ParseProgram(p);
+        if(Errors(p).size() == 0)
+            std::cout << input << " parsed without errors\n";
+    }
+}
+
+void TestGroupedExpressionParsing()
+{
+    std::vector<std::string> input_arr = {"(1 + 2) * 3", "2 / (5 + 5)", "-(5 + 5)", "!(true == true)", "1.0 / (i + 1)"};
+    std::vector<std::string> output_arr = {"((1 + 2) * 3)", "(2 / (5 + 5))", "(-(5 + 5))", "(!(true == true))", "(1.0 / (i + 1))"};
+
+    for(int i = 0; i < input_arr.size(); i++)
+    {
+        Lexer *l = New(input_arr[i]);
+        Parser *p = New(l);
+
+        Node *program = ParseProgram(p);
+        checkParserErrors(p);
+        std::string actual = program->Node_array[0]->Expression_identifier->String();
+        if(actual != output_arr[i])
+            std::cout << input_arr[i] << " parsed as " << actual << ", expected " << output_arr[i] << "\n";
     }
 }
 
@@ -183,15 +260,15 @@ void TestParsingPrefixExpressions()
         Node *program = ParseProgram(p);
         checkParserErrors(p);
 
-        if(program->Statements_program.size() != 1 )
-            std::cout << "program statements does not contains 1 statements!!!!" << " " << program->Statements_program.size();
+        if(program->Node_array.size() != 1 )
+            std::cout << "program statements does not contains 1 statements!!!!" << " " << program->Node_array.size();
 
-        if(program->Statements_program[0]->Expression_identifier->Operator != operator_arr[i])
+        if(program->Node_array[0]->Expression_identifier->Operator != operator_arr[i])
         {
-            std::cout << "exp.operator is not: " << operator_arr[i] << "operator is: " << program->Statements_program[0]->Expression_identifier->Operator << "\n";
+            std::cout << "exp.operator is not: " << operator_arr[i] << "operator is: " << program->Node_array[0]->Expression_identifier->Operator << "\n";
         }
 
-        if(!testIntegerLiteral(program->Statements_program[0]->Expression_identifier->Right_identifier, integer_value_arr[i]))
+        if(!testIntegerLiteral(program->Node_array[0]->Expression_identifier->Right_identifier, integer_value_arr[i]))
         {
             return;
         }
@@ -305,7 +382,7 @@ void TestIfExpression()
     checkParserErrors(p);
 
 
-    if(!testInfixExpression(program->Statements_program[0]->Expression_identifier->Condition_identifier, "x", "<", "y"))
+    if(!testInfixExpression(program->Node_array[0]->Expression_identifier->Condition_identifier, "x", "<", "y"))
     {
         std::cout << "test infix expression failed\n";
         return;
@@ -322,10 +399,10 @@ void TestFunctionalLiteralParsing()
 
     checkParserErrors(p);
 
-    testLiteralExpression(program->Statements_program[0]->Expression_identifier->Node_array[0],"x");
-    testLiteralExpression(program->Statements_program[0]->Expression_identifier->Node_array[1],"y");
+    testLiteralExpression(program->Node_array[0]->Expression_identifier->Node_array[0],"x");
+    testLiteralExpression(program->Node_array[0]->Expression_identifier->Node_array[1],"y");
 
-    testInfixExpression(program->Statements_program[0]->Expression_identifier->Body_statement->Expression_identifier, "x","+","y");
+    testInfixExpression(program->Node_array[0]->Expression_identifier->Body_statement->Expression_identifier, "x","+","y");
 }
 
 void TestFunctionParameterParsing()
@@ -343,7 +420,7 @@ void TestFunctionParameterParsing()
 
         for(int i = 0; i < expected_params.size();i++)
         {
-            testLiteralExpression(program->Statements_program[0]->Expression_identifier->Node_array[i], expected_params[j][i]);
+            testLiteralExpression(program->Node_array[0]->Expression_identifier->Node_array[i], expected_params[j][i]);
         }
     }
 }
@@ -358,19 +435,19 @@ void TestCallExpressionParsing()
 
     checkParserErrors(p);
 
-    if(!TestIdentifier(program->Statements_program[0]->Expression_identifier->Function_identifier, "add"))
+    if(!TestIdentifier(program->Node_array[0]->Expression_identifier->Function_identifier, "add"))
     {
        std::cout << "func name is not add, something wrong!!\n";
     }
 
 
-    if(program->Statements_program[0]->Expression_identifier->Node_array.size() != 3)
+    if(program->Node_array[0]->Expression_identifier->Node_array.size() != 3)
     {
-        std::cout << "Args size is not 3, is: " << program->Statements_program[0]->Expression_identifier->Node_array.size() << " something wrong!\n";
+        std::cout << "Args size is not 3, is: " << program->Node_array[0]->Expression_identifier->Node_array.size() << " something wrong!\n";
     }
-    testLiteralExpression(program->Statements_program[0]->Expression_identifier->Node_array[0], "1");
-    testInfixExpression(program->Statements_program[0]->Expression_identifier->Node_array[1],"2","*","3");
-    testInfixExpression(program->Statements_program[0]->Expression_identifier->Node_array[2], "4","+","5");
+    testLiteralExpression(program->Node_array[0]->Expression_identifier->Node_array[0], "1");
+    testInfixExpression(program->Node_array[0]->Expression_identifier->Node_array[1],"2","*","3");
+    testInfixExpression(program->Node_array[0]->Expression_identifier->Node_array[2], "4","+","5");
 }   
 
 void TestReturnStatement()
@@ -388,12 +465,12 @@ void TestReturnStatement()
 
         checkParserErrors(p);
 
-        if(program->Statements_program[0]->TokenLiteral() != "return")
+        if(program->Node_array[0]->TokenLiteral() != "return")
         {
-            std::cout << "token literal is not return, literal is: " << program->Statements_program[0]->TokenLiteral() << " something wrong\n";
+            std::cout << "token literal is not return, literal is: " << program->Node_array[0]->TokenLiteral() << " something wrong\n";
         }
 
-        if(!testLiteralExpression(program->Statements_program[0]->ReturnValue_identifier, expected_output[i]))
+        if(!testLiteralExpression(program->Node_array[0]->ReturnValue_identifier, expected_output[i]))
         {
             std::cout << "testliteral expression failed\n";
         }
@@ -416,11 +493,11 @@ void testLetStatements()
 
         checkParserErrors(p);
 
-        if(!TestLetStatement(program->Statements_program[0], expected_identifier[i]))
+        if(!TestLetStatement(program->Node_array[0], expected_identifier[i]))
         {
             std::cout << "testletstatement failed \n";
         }
-        if(!testLiteralExpression(program->Statements_program[0]->Value_identifier, expected_value[i]))
+        if(!testLiteralExpression(program->Node_array[0]->Value_identifier, expected_value[i]))
         {
             std::cout << "testliteralexpression faield\n";
         }
@@ -430,9 +507,10 @@ void testLetStatements()
     }
 }
 
-/*
 int main()
 {
   TestNextToken();
+  TestFloatLiteralTokens();
+  TestFloatLiteralExpression();
+  TestGroupedExpressionParsing();
 }
-*/
\ No newline at end of file
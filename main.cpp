@@ -4,6 +4,9 @@
 #include "parser/parser.h"
 #include "evaluator/evaluator.h"
 #include "environment/environment.h"
+#include "memory/heap.h"
+#include "memory/profiler.h"
+#include <fstream>
 #include <vector>
 
 #define PROMPT = ">> "
@@ -16,36 +19,41 @@ void printParserErrors(std::vector<std::string> errors)
     }
 }
 
-int main()
+int main(int argc, char **argv)
 {
-    /*
-void registerBuiltinFunctions(std::string func_name, std::function<Object(std::vector<Object *>)> function)
-
-Object builtinLenFunc(std::vector<Object *> arguments)
-    */
     std::string scan;
     std::cout << "Welcome to the ___ language\n";
     
-    Object (*lenFuncPtr)(std::vector<Object *> arguments);
-    lenFuncPtr = &builtinLenFunc;
-    registerBuiltinFunctions("len", lenFuncPtr);
-
-
-    Object (*pushFuncPtr)(std::vector<Object *> arguments);
-    pushFuncPtr = &builtinPushFunc;
-    registerBuiltinFunctions("push", pushFuncPtr);
+    registerBuiltins();
 
+    std::string profile_path;
+    // --heap-limit=BYTES caps what scripts can keep alive, past it a line evaluates to an out of memory error
+    for(int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if(arg.rfind("--heap-limit=", 0) == 0)
+            MyMemory::setHeapLimit(std::stoul(arg.substr(13)));
+        // --alloc-profile=PATH writes allocation sites to PATH and folded stacks to PATH.folded at exit
+        else if(arg.rfind("--alloc-profile=", 0) == 0)
+        {
+            profile_path = arg.substr(16);
+            MyMemory::profiling = true;
+        }
+    }
 
-    Object (*printFuncPtr)(std::vector<Object *> arguments);
-    printFuncPtr = &builtinPrintFunc;
-    registerBuiltinFunctions("print", printFuncPtr);
-
-    MyEnv::Env *env = MyEnv::newEnv();
+    MyEnv::Env *env = MyMemory::pin(MyEnv::newEnv());
+    MyMemory::Arena arena;
+    int line_number = 0;
     while(true)
     {
         std::cout << ">> ";
-        std::getline(std::cin, scan);
-        Lexer *l = New(scan);
+        if(!std::getline(std::cin, scan))
+            break;
+
+        // everything the line allocates lives in the arena, only what reaches env is promoted
+        MyMemory::current = &arena;
+        line_number += 1;
+        Lexer *l = New(scan, line_number);
         Parser *p = New(l);
 
         Node *program = ParseProgram(p);
@@ -53,29 +61,43 @@ Object builtinLenFunc(std::vector<Object *> arguments)
         if(p->errors.size() != 0)
         {
             printParserErrors(p->errors);
-            continue;
         }
-
-        Object *evaluated = Eval(program, env);
-        if(evaluated->which_object == STRING_OBJ || evaluated->which_object == INTEGER_OBJ || evaluated->which_object == RETURN_VALUE_OBJ
-        || evaluated->which_object == ERROR_OBJ || evaluated->which_object == BOOLEAN_OBJ || evaluated->which_object == ARRAY_OBJ)
-        {
-            std::string return_str = evaluated->Inspect(evaluated);
-            std::cout << return_str << "\n";
-        }
-        else if(evaluated->which_object == NULL_OBJ)
-        {
-            std::cout << "null" << "\n";
-        }
-        else if(evaluated->which_object == "")
+        else
         {
-            std::string return_str = evaluated->Inspect(evaluated);
-            std::cout <<"WHICH OBJECT EMPTY EGLDI: "<< return_str << "\n";
+            Object *evaluated = Eval(program, env);
+            bool is_let = program->Node_array.size() != 0 && program->Node_array.back()->which_statement == "LetStatement";
+            if(evaluated->which_object == STRING_OBJ || evaluated->which_object == INTEGER_OBJ || evaluated->which_object == BIGINT_OBJ
+            || evaluated->which_object == FLOAT_OBJ || evaluated->which_object == RETURN_VALUE_OBJ
+            || evaluated->which_object == ERROR_OBJ || evaluated->which_object == BOOLEAN_OBJ || evaluated->which_object == ARRAY_OBJ
+            || evaluated->which_object == HASH_OBJ || evaluated->which_object == VECTOR_OBJ || evaluated->which_object == MAP_OBJ)
+            {
+                std::string return_str = evaluated->Inspect(evaluated);
+                std::cout << return_str << "\n";
+            }
+            else if(evaluated->which_object == NULL_OBJ && !is_let)
+            {
+                std::cout << "null" << "\n";
+            }
+            else if(evaluated->which_object == "")
+            {
+                std::string return_str = evaluated->Inspect(evaluated);
+                std::cout <<"WHICH OBJECT EMPTY EGLDI: "<< return_str << "\n";
+            }
         }
 
-    
-        free(l);
-        free(p);
+        delete p;
+        delete l;
+        MyMemory::current = NULL;
+        arena.reset();
+        MyMemory::safepoint();
+    }
+
+    if(MyMemory::profiling)
+    {
+        std::ofstream report(profile_path);
+        MyMemory::writeProfileReport(report);
+        std::ofstream folded(profile_path + ".folded");
+        MyMemory::writeFoldedStacks(folded);
     }
 }
 
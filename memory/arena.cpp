@@ -0,0 +1,266 @@
+#include "arena.h"
+#include "heap.h"
+#include "profiler.h"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+MyMemory::Arena *MyMemory::current = NULL;
+
+static std::size_t alignSize(std::size_t size)
+{
+    return (size + 15) & ~(std::size_t)15;
+}
+
+MyMemory::BlockHeader *MyMemory::headerOf(const void *ptr)
+{
+    return (MyMemory::BlockHeader *)((char *)ptr - sizeof(MyMemory::BlockHeader));
+}
+
+MyMemory::Arena::Arena(std::size_t chunk_size)
+{
+    this->chunk_size = chunk_size;
+    this->current_chunk = 0;
+    this->finalizers = NULL;
+    this->epoch = 0;
+    this->last_epoch = 0;
+}
+
+MyMemory::Arena::~Arena()
+{
+    reset();
+    for(auto &chunk: chunks)
+        std::free(chunk.data);
+    chunks.clear();
+}
+
+void *MyMemory::Arena::allocate(std::size_t size, void (*finalizer)(void *), BlockKind kind)
+{
+    std::size_t needed = sizeof(BlockHeader) + alignSize(size);
+
+    // the limit is checked whenever a chunk is taken, so a line overshoots it by at most one chunk
+    if(current_chunk == chunks.size() || chunks[current_chunk].size - chunks[current_chunk].used < needed)
+        reserveHeap(needed > chunk_size ? needed : chunk_size);
+    while(current_chunk < chunks.size() && chunks[current_chunk].size - chunks[current_chunk].used < needed)
+    {
+        current_chunk += 1;
+        if(current_chunk < chunks.size())
+            chunks[current_chunk].used = 0;
+    }
+    if(current_chunk == chunks.size())
+    {
+        Chunk chunk;
+        chunk.size = needed > chunk_size ? needed : chunk_size;
+        chunk.data = (char *)std::malloc(chunk.size);
+        if(chunk.data == NULL)
+            throw std::bad_alloc();
+        chunk.used = 0;
+        chunks.push_back(chunk);
+    }
+
+    Chunk &chunk = chunks[current_chunk];
+    BlockHeader *header = (BlockHeader *)(chunk.data + chunk.used);
+    chunk.used += needed;
+
+    std::memset(header, 0, sizeof(BlockHeader));
+    header->in_arena = true;
+    header->kind = kind;
+    header->size = size;
+    header->finalizer = finalizer;
+    header->epoch = epoch;
+    if(finalizer != NULL)
+    {
+        header->next = finalizers;
+        finalizers = header;
+    }
+    return (char *)header + sizeof(BlockHeader);
+}
+
+// runs the destructors of the blocks allocated after until, newest first
+static MyMemory::BlockHeader *runFinalizers(MyMemory::BlockHeader *header, MyMemory::BlockHeader *until)
+{
+    while(header != until)
+    {
+        MyMemory::BlockHeader *next = header->next;
+        if(header->finalizer != NULL)
+            header->finalizer((char *)header + sizeof(MyMemory::BlockHeader));
+        header = next;
+    }
+    return until;
+}
+
+static void dropHeld(std::vector<MyMemory::BlockHeader *> &held, std::size_t count)
+{
+    for(std::size_t i = count; i < held.size(); i++)
+        held[i]->held = false;
+    held.resize(count);
+}
+
+// Members of Object, Env and Node are std containers, so their destructors still run here;
+// the chunks themselves are handed back by rewinding, whatever the number of temporaries.
+void MyMemory::Arena::reset()
+{
+    if(profiling)
+        tallyProfiledLine();
+    finalizers = runFinalizers(finalizers, NULL);
+    dropHeld(held, 0);
+    marks.clear();
+    epoch = 0;
+    last_epoch = 0;
+
+    current_chunk = 0;
+    if(!chunks.empty())
+        chunks[0].used = 0;
+}
+
+void MyMemory::Arena::pushMark()
+{
+    Mark mark;
+    mark.chunk = current_chunk;
+    mark.used = current_chunk < chunks.size() ? chunks[current_chunk].used : 0;
+    mark.finalizers = finalizers;
+    mark.held = held.size();
+    mark.profiled = profiling ? pendingAllocations() : 0;
+    mark.outer_epoch = epoch;
+    mark.epoch = ++last_epoch;
+    mark.kept = false;
+    marks.push_back(mark);
+    epoch = mark.epoch;
+}
+
+void MyMemory::Arena::rewindMark()
+{
+    Mark &mark = marks.back();
+    // what C++ frames of the iteration held, they have all returned
+    dropHeld(held, mark.held);
+    if(mark.kept)
+    {
+        mark.chunk = current_chunk;
+        mark.used = current_chunk < chunks.size() ? chunks[current_chunk].used : 0;
+        mark.finalizers = finalizers;
+        mark.profiled = profiling ? pendingAllocations() : 0;
+        mark.epoch = ++last_epoch;
+        mark.kept = false;
+        epoch = mark.epoch;
+        return;
+    }
+    // the profiler still reads the types of what it is going to lose
+    if(profiling)
+        tallyProfiledAllocations(mark.profiled);
+    finalizers = runFinalizers(finalizers, mark.finalizers);
+    current_chunk = mark.chunk;
+    if(current_chunk < chunks.size())
+        chunks[current_chunk].used = mark.used;
+    // blocks of nested loops' last iterations went with it
+    epoch = mark.epoch;
+}
+
+// what the last iteration allocated stays, it belongs to the enclosing iteration now
+void MyMemory::Arena::popMark()
+{
+    epoch = marks.back().outer_epoch;
+    marks.pop_back();
+}
+
+bool MyMemory::Arena::separated(const void *container, const void *value)
+{
+    unsigned int container_epoch = headerOf(container)->epoch;
+    unsigned int value_epoch = headerOf(value)->epoch;
+    // marks are in increasing epoch order, the oldest one newer than container decides
+    bool found = false;
+    for(std::size_t i = marks.size(); i > 0 && marks[i - 1].epoch > container_epoch; i--)
+        found = marks[i - 1].epoch <= value_epoch;
+    return found;
+}
+
+void MyMemory::Arena::keepIteration(const void *container, const void *value)
+{
+    unsigned int container_epoch = headerOf(container)->epoch;
+    unsigned int value_epoch = headerOf(value)->epoch;
+    for(std::size_t i = marks.size(); i > 0 && marks[i - 1].epoch > container_epoch; i--)
+    {
+        if(marks[i - 1].epoch <= value_epoch)
+            marks[i - 1].kept = true;
+    }
+}
+
+bool MyMemory::Arena::outlivesIteration(const void *block)
+{
+    return !marks.empty() && headerOf(block)->epoch < epoch;
+}
+
+MyMemory::LoopMark::LoopMark()
+{
+    arena = current;
+    if(arena != NULL)
+        arena->pushMark();
+}
+
+MyMemory::LoopMark::~LoopMark()
+{
+    if(arena != NULL)
+        arena->popMark();
+}
+
+void MyMemory::LoopMark::nextIteration()
+{
+    if(arena == NULL)
+        return;
+    arena->rewindMark();
+    iterationSafepoint();
+}
+
+void MyMemory::Arena::hold(void *ptr)
+{
+    if(ptr == NULL)
+        return;
+    BlockHeader *header = headerOf(ptr);
+    if(header->in_arena || header->held)
+        return;
+    header->held = true;
+    held.push_back(header);
+}
+
+std::size_t MyMemory::Arena::bytesUsed()
+{
+    std::size_t total = 0;
+    for(std::size_t i = 0; i < chunks.size() && i <= current_chunk; i++)
+        total += chunks[i].used;
+    return total;
+}
+
+void *MyMemory::allocate(std::size_t size, void (*finalizer)(void *), BlockKind kind)
+{
+    if(current != NULL)
+        return current->allocate(size, finalizer, kind);
+    return heapAllocate(size, finalizer, kind);
+}
+
+void MyMemory::release(void *ptr)
+{
+    if(ptr == NULL)
+        return;
+    BlockHeader *header = headerOf(ptr);
+    if(header->in_arena)
+    {
+        // the destructor already ran, keep reset() from running it again
+        header->finalizer = NULL;
+        return;
+    }
+    heapRelease(header);
+}
+
+bool MyMemory::inArena(const void *ptr)
+{
+    if(ptr == NULL)
+        return false;
+    return headerOf(ptr)->in_arena;
+}
+
+char *MyMemory::copyString(const char *str, std::size_t length)
+{
+    char *copy = (char *)allocate(length + 1, NULL, RAW_BLOCK);
+    std::memcpy(copy, str, length);
+    copy[length] = 0;
+    return copy;
+}
@@ -0,0 +1,154 @@
+#ifndef __ARENA_HEADER__
+#define __ARENA_HEADER__
+
+#include <cstddef>
+#include <vector>
+
+class Object;
+class Node;
+namespace MyEnv
+{
+    class Env;
+}
+
+namespace MyMemory
+{
+    enum BlockKind { RAW_BLOCK, OBJECT_BLOCK, ENV_BLOCK, NODE_BLOCK, TRIE_BLOCK };
+
+    // Every Object, Env, Node and TrieNode is preceded by this header, both in the arena and on the heap.
+    struct alignas(16) BlockHeader
+    {
+        BlockHeader *next;
+        BlockHeader *prev;
+        void (*finalizer)(void *);
+        std::size_t size;
+        int refcount;
+        unsigned char kind;
+        unsigned char color;
+        bool in_arena;
+        bool marked;
+        bool pinned;
+        bool buffered;
+        // on the running line's held list
+        bool held;
+        // see makeWeak(), its finalizer is what forgets it
+        bool weak;
+        // arena blocks: the iteration of the innermost running loop it was allocated in, see pushMark()
+        unsigned int epoch;
+    };
+
+    class Arena
+    {
+        public:
+            Arena(std::size_t chunk_size = 64 * 1024);
+            ~Arena();
+
+            void *allocate(std::size_t size, void (*finalizer)(void *), BlockKind kind);
+            void reset();
+            std::size_t bytesUsed();
+            // keeps a heap value alive until reset(), the evaluator passes it everything it hands back to a
+            // C++ frame, which may hold it after the binding or element it came from is gone
+            void hold(void *ptr);
+
+            // A loop pushes a mark before its first iteration and rewinds to it after each one, handing back
+            // what the iteration allocated, so a loop needs the arena of one iteration rather than of all.
+            // Blocks are stamped with the epoch of the iteration they were allocated in, every mark has a
+            // higher one than the blocks before it.
+            void pushMark();
+            // an iteration that gave something older than the mark a value of its own is kept, the mark
+            // moves past it instead
+            void rewindMark();
+            void popMark();
+            // true when some mark's rewind would free value but not container
+            bool separated(const void *container, const void *value);
+            // keeps every iteration separating container from value
+            void keepIteration(const void *container, const void *value);
+            // true when what is allocated now could be rewound before block is
+            bool outlivesIteration(const void *block);
+
+            // blocks whose destructor has not run yet, they are roots for a collection started mid-line
+            template<typename F>
+            void forEachBlock(F visit)
+            {
+                for(BlockHeader *header = finalizers; header != NULL; header = header->next)
+                {
+                    if(header->finalizer != NULL)
+                        visit(header);
+                }
+            }
+
+            template<typename F>
+            void forEachHeld(F visit)
+            {
+                for(auto header: held)
+                    visit(header);
+            }
+
+        private:
+            struct Chunk
+            {
+                char *data;
+                std::size_t size;
+                std::size_t used;
+            };
+
+            struct Mark
+            {
+                std::size_t chunk;
+                std::size_t used;
+                BlockHeader *finalizers;
+                std::size_t held;
+                std::size_t profiled;
+                unsigned int epoch;
+                // what epoch was when the mark was pushed
+                unsigned int outer_epoch;
+                bool kept;
+            };
+
+            std::vector<Chunk> chunks;
+            std::size_t current_chunk;
+            std::size_t chunk_size;
+            BlockHeader *finalizers;
+            std::vector<BlockHeader *> held;
+            std::vector<Mark> marks;
+            // stamped into every block allocated, the epoch of the innermost mark or 0 outside any loop
+            unsigned int epoch;
+            unsigned int last_epoch;
+    };
+
+    // Held by a loop while it runs, over the arena of the running line if there is one.
+    class LoopMark
+    {
+        public:
+            LoopMark();
+            ~LoopMark();
+            // between iterations, once nothing the last one allocated is needed by the loop itself
+            void nextIteration();
+        private:
+            Arena *arena;
+    };
+
+    // Arena temporaries are allocated from while a top-level evaluation runs, NULL otherwise.
+    extern Arena *current;
+
+    void *allocate(std::size_t size, void (*finalizer)(void *), BlockKind kind);
+    void release(void *ptr);
+    bool inArena(const void *ptr);
+    char *copyString(const char *str, std::size_t length);
+
+    template<typename T>
+    void destroy(void *ptr)
+    {
+        static_cast<T *>(ptr)->~T();
+    }
+
+    BlockHeader *headerOf(const void *ptr);
+
+    Object *promoteObject(Object *obj);
+    MyEnv::Env *promoteEnv(MyEnv::Env *env);
+    // what to store into container in place of value, a heap copy of value when container might
+    // outlive it; on the heap, or in the arena and older than the loop iteration value was made in
+    Object *storable(const void *container, Object *value);
+}
+
+#endif
@@ -0,0 +1,1024 @@
+#include "heap.h"
+#include "../object/object.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <unordered_set>
+
+using MyMemory::BlockHeader;
+
+// tracing collections start once the heap has grown this much past what the last one left live
+#define INITIAL_COLLECTION_THRESHOLD (1024 * 1024)
+
+// at most this many candidate cycle roots are examined per collection. That caps how much of the
+// candidate buffer one pause drains, not the pause: trial deletion walks everything reachable from
+// the roots it takes, so a pause is still linear in the size of the structures involved.
+#define CYCLE_ROOT_BUDGET 256
+
+// at most about this many blocks are freed or have their count dropped per safepoint, the rest of
+// the zero-count worklist waits for the next one; only collect() drains it. The children of a
+// single block are still visited in one go.
+#define FREE_BUDGET 4096
+
+static BlockHeader *heap_blocks = NULL;
+static void *held_root = NULL;
+bool MyMemory::limit_deferred = false;
+
+MyMemory::HeapStats &MyMemory::heapStats()
+{
+    static HeapStats *stats = new HeapStats();
+    return *stats;
+}
+
+// function-local so blocks pinned from static initializers see a constructed vector
+static std::vector<BlockHeader *> &pinnedBlocks()
+{
+    static std::vector<BlockHeader *> *pinned = new std::vector<BlockHeader *>();
+    return *pinned;
+}
+
+static void *payloadOf(BlockHeader *header)
+{
+    return (char *)header + sizeof(BlockHeader);
+}
+
+static void linkBlock(BlockHeader *header)
+{
+    header->prev = NULL;
+    header->next = heap_blocks;
+    if(heap_blocks != NULL)
+        heap_blocks->prev = header;
+    heap_blocks = header;
+}
+
+static void unlinkBlock(BlockHeader *header)
+{
+    if(header->prev != NULL)
+        header->prev->next = header->next;
+    else
+        heap_blocks = header->next;
+    if(header->next != NULL)
+        header->next->prev = header->prev;
+}
+
+template<typename F>
+static void visitPointer(void *ptr, F &visit)
+{
+    if(ptr != NULL && !MyMemory::inArena(ptr))
+        visit(MyMemory::headerOf(ptr));
+}
+
+// every heap pointer a block holds; tracing, counting and trial deletion all walk the same edges
+template<typename F>
+static void forEachChild(BlockHeader *header, F visit)
+{
+    void *ptr = payloadOf(header);
+    if(header->kind == MyMemory::OBJECT_BLOCK)
+    {
+        Object *obj = (Object *)ptr;
+        if(obj->which_object == STRING_OBJ || obj->which_object == RETURN_VALUE_OBJ || obj->which_object == BIGINT_OBJ)
+            visitPointer(obj->Value, visit);
+        visitPointer(obj->rope_left, visit);
+        visitPointer(obj->rope_right, visit);
+        visitPointer(obj->body, visit);
+        for(auto param: obj->parameters)
+            visitPointer(param, visit);
+        visitPointer(obj->env, visit);
+        obj->elements.forEachObject([&visit](Object *ptr) { visitPointer(ptr, visit); });
+        obj->HashPair.forEachObject([&visit](Object *ptr) { visitPointer(ptr, visit); });
+        obj->vector_trie.forEachNode([&visit](TrieNode *node) { visitPointer(node, visit); });
+        obj->map_trie.forEachNode([&visit](TrieNode *node) { visitPointer(node, visit); });
+    }
+    else if(header->kind == MyMemory::TRIE_BLOCK)
+    {
+        TrieNode *node = (TrieNode *)ptr;
+        for(auto value: node->values)
+            visitPointer(value, visit);
+        for(auto child: node->children)
+            visitPointer(child, visit);
+        for(auto &entry: node->entries)
+        {
+            visitPointer(entry.key, visit);
+            visitPointer(entry.value, visit);
+        }
+    }
+    else if(header->kind == MyMemory::ENV_BLOCK)
+    {
+        MyEnv::Env *env = (MyEnv::Env *)ptr;
+        env->store.forEachBinding([&visit](const std::string &, Object *value) { visitPointer(value, visit); });
+        for(auto value: env->globals)
+            visitPointer(value, visit);
+        visitPointer(env->outer, visit);
+    }
+    else if(header->kind == MyMemory::NODE_BLOCK)
+    {
+        Node *node = (Node *)ptr;
+        visitPointer(node->Right_identifier, visit);
+        visitPointer(node->Left_identifier, visit);
+        visitPointer(node->Condition_identifier, visit);
+        visitPointer(node->Consequence_statement, visit);
+        visitPointer(node->Alternative_statement, visit);
+        visitPointer(node->Body_statement, visit);
+        visitPointer(node->Function_identifier, visit);
+        visitPointer(node->Name_identifier, visit);
+        visitPointer(node->Value_identifier, visit);
+        visitPointer(node->ReturnValue_identifier, visit);
+        visitPointer(node->Expression_identifier, visit);
+        visitPointer(node->Left_index, visit);
+        visitPointer(node->Right_index, visit);
+        visitPointer(node->Index, visit);
+        for(auto child: node->Node_array)
+            visitPointer(child, visit);
+        for(auto &vk: node->Pairs)
+        {
+            visitPointer(vk.first, visit);
+            visitPointer(vk.second, visit);
+        }
+    }
+}
+
+#ifdef REFCOUNT_MEMORY
+static std::unordered_set<BlockHeader *> &zeroCountTable()
+{
+    static std::unordered_set<BlockHeader *> table;
+    return table;
+}
+
+static std::unordered_set<BlockHeader *> &cycleCandidates()
+{
+    static std::unordered_set<BlockHeader *> candidates;
+    return candidates;
+}
+
+// blocks known to be dead whose children have not been released yet, kept between safepoints
+static std::vector<BlockHeader *> &freeWorklist()
+{
+    static std::vector<BlockHeader *> worklist;
+    return worklist;
+}
+#else
+// weak blocks still to be checked when marking finishes
+static std::unordered_set<BlockHeader *> &weakBlocks()
+{
+    static std::unordered_set<BlockHeader *> blocks;
+    return blocks;
+}
+#endif
+
+static void freeBlock(BlockHeader *header)
+{
+    MyMemory::HeapStats &stats = MyMemory::heapStats();
+    unlinkBlock(header);
+#ifdef REFCOUNT_MEMORY
+    zeroCountTable().erase(header);
+    if(header->buffered)
+        cycleCandidates().erase(header);
+#else
+    if(header->weak)
+        weakBlocks().erase(header);
+#endif
+    if(header->finalizer != NULL)
+        header->finalizer(payloadOf(header));
+    stats.heap_bytes -= header->size;
+    stats.heap_blocks -= 1;
+    stats.frees += 1;
+    std::free(header);
+}
+
+// the block is dead, its owner lets go of it before it is freed
+static void forgetWeak(BlockHeader *header)
+{
+    void (*forget)(void *) = header->finalizer;
+    header->weak = false;
+    header->finalizer = NULL;
+    forget(payloadOf(header));
+}
+
+static void countBlock(BlockHeader *header)
+{
+    MyMemory::HeapStats &stats = MyMemory::heapStats();
+    linkBlock(header);
+    stats.heap_bytes += header->size;
+    stats.peak_heap_bytes = std::max(stats.peak_heap_bytes, stats.heap_bytes);
+    stats.heap_blocks += 1;
+    stats.allocations += 1;
+}
+
+static void registerBlock(BlockHeader *header);
+static void unregisterBlock(BlockHeader *header);
+static std::size_t liveHeapBytes();
+static void pollCollection();
+
+// a collection started in the middle of a line must keep what the line's temporaries point at
+template<typename F>
+static void forEachExtraRoot(F visit)
+{
+    if(MyMemory::current != NULL)
+    {
+        MyMemory::current->forEachBlock([&visit](BlockHeader *header) { forEachChild(header, visit); });
+        MyMemory::current->forEachHeld(visit);
+    }
+    if(held_root != NULL)
+        visit(MyMemory::headerOf(held_root));
+}
+
+static bool overLimit(std::size_t size)
+{
+    std::size_t limit = MyMemory::heapStats().heap_limit;
+    std::size_t arena_bytes = MyMemory::current != NULL ? MyMemory::current->bytesUsed() : 0;
+    std::size_t external_bytes = MyMemory::heapStats().external_bytes;
+    return limit != 0 && liveHeapBytes() + external_bytes + arena_bytes + size > limit;
+}
+
+void MyMemory::noteExternalBytes(long delta)
+{
+    heapStats().external_bytes += delta;
+}
+
+void MyMemory::setHeapLimit(std::size_t bytes)
+{
+    heapStats().heap_limit = bytes;
+}
+
+// also where a line that never reaches a loop's back-edge gets its collections started; promotion and
+// the other copies that defer the limit are not finished, nor is anything outside a line rooted
+void MyMemory::reserveHeap(std::size_t size, void *held)
+{
+    if(limit_deferred)
+        return;
+    bool over = overLimit(size);
+    held_root = held;
+    if(over)
+        collect();
+    else if(current != NULL)
+        pollCollection();
+    held_root = NULL;
+    if(over && overLimit(size))
+        throw HeapExhausted();
+}
+
+void *MyMemory::heapAllocate(std::size_t size, void (*finalizer)(void *), BlockKind kind)
+{
+    reserveHeap(size);
+    BlockHeader *header = (BlockHeader *)std::malloc(sizeof(BlockHeader) + size);
+    if(header == NULL)
+        throw std::bad_alloc();
+    std::memset(header, 0, sizeof(BlockHeader));
+    header->kind = kind;
+    header->size = size;
+    header->finalizer = finalizer;
+    registerBlock(header);
+    return payloadOf(header);
+}
+
+// explicit delete of a heap block, its destructor has already run
+void MyMemory::heapRelease(BlockHeader *header)
+{
+    header->finalizer = NULL;
+    unregisterBlock(header);
+}
+
+void MyMemory::pinBlock(void *ptr)
+{
+    if(ptr == NULL || inArena(ptr))
+        return;
+    BlockHeader *header = headerOf(ptr);
+    if(!header->pinned)
+    {
+        header->pinned = true;
+        pinnedBlocks().push_back(header);
+    }
+}
+
+void MyMemory::recordPause(double us)
+{
+    HeapStats &stats = heapStats();
+    stats.pauses_us[stats.pauses_recorded % PAUSE_WINDOW] = us;
+    stats.pauses_recorded += 1;
+    stats.total_pause_us += us;
+    stats.max_pause_us = std::max(stats.max_pause_us, us);
+}
+
+void MyMemory::clearPauses()
+{
+    HeapStats &stats = heapStats();
+    stats.pauses_recorded = 0;
+    stats.total_pause_us = 0;
+    stats.max_pause_us = 0;
+}
+
+double MyMemory::pausePercentile(double percentile)
+{
+    HeapStats &stats = heapStats();
+    std::vector<double> pauses(stats.pauses_us, stats.pauses_us + std::min(stats.pauses_recorded, PAUSE_WINDOW));
+    if(pauses.empty())
+        return 0;
+    std::sort(pauses.begin(), pauses.end());
+    std::size_t index = (std::size_t)(percentile / 100 * (pauses.size() - 1));
+    return pauses[index];
+}
+
+#ifdef REFCOUNT_MEMORY
+
+static void registerBlock(BlockHeader *header)
+{
+    countBlock(header);
+    // nothing on the heap points at it yet, the next collect() frees it unless a store does
+    zeroCountTable().insert(header);
+}
+
+static void unregisterBlock(BlockHeader *header)
+{
+    freeBlock(header);
+}
+
+// the zero-count table only holds blocks whose count is zero, so a safepoint's budget is not spent
+// on the ones stored since they were allocated
+static void incRef(BlockHeader *header)
+{
+    if(header->pinned)
+        return;
+    if(header->refcount == 0)
+        zeroCountTable().erase(header);
+    header->refcount += 1;
+    header->color = MyMemory::BLACK;
+}
+
+static void possibleRoot(BlockHeader *header)
+{
+    if(header->color != MyMemory::PURPLE)
+    {
+        header->color = MyMemory::PURPLE;
+        if(!header->buffered)
+        {
+            header->buffered = true;
+            cycleCandidates().insert(header);
+        }
+    }
+}
+
+static void decRef(BlockHeader *header)
+{
+    if(header->pinned)
+        return;
+    header->refcount -= 1;
+    if(header->refcount == 0)
+        zeroCountTable().insert(header);
+    else
+        possibleRoot(header);
+}
+
+// there is no concurrent collector to keep out in this mode
+MyMemory::HeapLock::HeapLock(void *)
+{
+    locked = false;
+}
+
+MyMemory::HeapLock::~HeapLock()
+{
+}
+
+void MyMemory::writeBarrier(void *container, void *old_value, void *new_value)
+{
+    if(container == NULL || inArena(container))
+        return;
+    if(new_value != NULL && !inArena(new_value))
+        incRef(headerOf(new_value));
+    if(old_value != NULL && !inArena(old_value))
+        decRef(headerOf(old_value));
+}
+
+void MyMemory::notePromoted(void *block)
+{
+    forEachChild(headerOf(block), [](BlockHeader *child) { incRef(child); });
+}
+
+// forgotten as soon as a collection finds its count at zero, a block still in the owner's table is live
+void MyMemory::makeWeak(void *ptr, void (*forget)(void *))
+{
+    BlockHeader *header = headerOf(ptr);
+    header->weak = true;
+    header->finalizer = forget;
+}
+
+void *MyMemory::readWeak(void *ptr)
+{
+    return ptr;
+}
+
+// a block in the zero-count table is dead if its count is still zero while the arena's references
+// are held, and stays dead, so it can wait on the worklist; a child dropping to zero is dead the same way
+static void freeZeroCountBlocks(std::size_t budget)
+{
+    std::vector<BlockHeader *> &worklist = freeWorklist();
+    std::size_t work = 0;
+    while(work < budget)
+    {
+        if(worklist.empty())
+        {
+            if(zeroCountTable().empty())
+                break;
+            BlockHeader *header = *zeroCountTable().begin();
+            zeroCountTable().erase(zeroCountTable().begin());
+            work += 1;
+            if(header->refcount == 0 && !header->pinned)
+            {
+                if(header->weak)
+                    forgetWeak(header);
+                worklist.push_back(header);
+            }
+            continue;
+        }
+        BlockHeader *header = worklist.back();
+        worklist.pop_back();
+        forEachChild(header, [&worklist, &work](BlockHeader *child) {
+            work += 1;
+            if(child->pinned)
+                return;
+            child->refcount -= 1;
+            if(child->refcount == 0)
+            {
+                if(child->weak)
+                    forgetWeak(child);
+                worklist.push_back(child);
+            }
+            else
+            {
+                possibleRoot(child);
+            }
+        });
+        freeBlock(header);
+        work += 1;
+    }
+}
+
+static void markGray(BlockHeader *root)
+{
+    if(root->color == MyMemory::GRAY)
+        return;
+    root->color = MyMemory::GRAY;
+    std::vector<BlockHeader *> stack(1, root);
+    while(!stack.empty())
+    {
+        BlockHeader *header = stack.back();
+        stack.pop_back();
+        forEachChild(header, [&stack](BlockHeader *child) {
+            if(child->pinned)
+                return;
+            child->refcount -= 1;
+            if(child->color != MyMemory::GRAY)
+            {
+                child->color = MyMemory::GRAY;
+                stack.push_back(child);
+            }
+        });
+    }
+}
+
+static void scanBlack(BlockHeader *root)
+{
+    root->color = MyMemory::BLACK;
+    std::vector<BlockHeader *> stack(1, root);
+    while(!stack.empty())
+    {
+        BlockHeader *header = stack.back();
+        stack.pop_back();
+        forEachChild(header, [&stack](BlockHeader *child) {
+            if(child->pinned)
+                return;
+            child->refcount += 1;
+            if(child->color != MyMemory::BLACK)
+            {
+                child->color = MyMemory::BLACK;
+                stack.push_back(child);
+            }
+        });
+    }
+}
+
+static void scan(BlockHeader *root)
+{
+    std::vector<BlockHeader *> stack(1, root);
+    while(!stack.empty())
+    {
+        BlockHeader *header = stack.back();
+        stack.pop_back();
+        if(header->color != MyMemory::GRAY)
+            continue;
+        if(header->refcount > 0)
+        {
+            scanBlack(header);
+            continue;
+        }
+        header->color = MyMemory::WHITE;
+        forEachChild(header, [&stack](BlockHeader *child) {
+            if(!child->pinned)
+                stack.push_back(child);
+        });
+    }
+}
+
+static void collectWhite(BlockHeader *root, std::vector<BlockHeader *> &garbage)
+{
+    if(root->color != MyMemory::WHITE || root->buffered)
+        return;
+    root->color = MyMemory::BLACK;
+    std::vector<BlockHeader *> stack(1, root);
+    while(!stack.empty())
+    {
+        BlockHeader *header = stack.back();
+        stack.pop_back();
+        garbage.push_back(header);
+        forEachChild(header, [&stack](BlockHeader *child) {
+            if(child->color == MyMemory::WHITE && !child->buffered)
+            {
+                child->color = MyMemory::BLACK;
+                stack.push_back(child);
+            }
+        });
+    }
+}
+
+// synchronous trial deletion (Bacon & Rajan) from a bounded slice of the candidate buffer; the walks
+// from each root run to completion, counts are only consistent again once scan has finished
+static void collectCycles()
+{
+    std::vector<BlockHeader *> roots;
+    for(auto header: cycleCandidates())
+    {
+        if((int)roots.size() == CYCLE_ROOT_BUDGET)
+            break;
+        roots.push_back(header);
+    }
+
+    std::vector<BlockHeader *> marked;
+    for(auto header: roots)
+    {
+        cycleCandidates().erase(header);
+        if(header->color == MyMemory::PURPLE && header->refcount > 0)
+        {
+            markGray(header);
+            marked.push_back(header);
+        }
+        else
+        {
+            header->buffered = false;
+        }
+    }
+    for(auto header: marked)
+        scan(header);
+
+    std::vector<BlockHeader *> garbage;
+    for(auto header: marked)
+    {
+        header->buffered = false;
+        collectWhite(header, garbage);
+    }
+    for(auto header: garbage)
+        freeBlock(header);
+}
+
+static std::size_t liveHeapBytes()
+{
+    return MyMemory::heapStats().heap_bytes;
+}
+
+static std::size_t next_collection = INITIAL_COLLECTION_THRESHOLD;
+
+// frees up to budget worth of the zero-count blocks, then looks for cycles once nothing is left over
+static void collectSlice(std::size_t budget)
+{
+    auto start = std::chrono::steady_clock::now();
+    // references from the arena are not counted, hold them for the duration of the collection
+    std::vector<BlockHeader *> extra_roots;
+    forEachExtraRoot([&extra_roots](BlockHeader *header) {
+        incRef(header);
+        extra_roots.push_back(header);
+    });
+    freeZeroCountBlocks(budget);
+    if(freeWorklist().empty())
+        collectCycles();
+    for(auto header: extra_roots)
+        decRef(header);
+    std::chrono::duration<double, std::micro> pause = std::chrono::steady_clock::now() - start;
+
+    MyMemory::HeapStats &stats = MyMemory::heapStats();
+    if(freeWorklist().empty())
+        next_collection = std::max<std::size_t>(stats.heap_bytes * 2, INITIAL_COLLECTION_THRESHOLD);
+    stats.collections += 1;
+    MyMemory::recordPause(pause.count());
+}
+
+void MyMemory::collect()
+{
+    collectSlice(SIZE_MAX);
+}
+
+// a block just allocated has no counted references until it is stored, so allocating frees nothing
+static void pollCollection()
+{
+}
+
+void MyMemory::safepoint()
+{
+    collectSlice(FREE_BUDGET);
+}
+
+// the running line's arena and held values are held like at any other collection
+void MyMemory::iterationSafepoint()
+{
+    if(!freeWorklist().empty() || heapStats().heap_bytes >= next_collection)
+        collectSlice(FREE_BUDGET);
+}
+
+const char *MyMemory::memoryMode()
+{
+    return "refcount";
+}
+
+#else
+
+// Tracing collections run concurrently with the evaluator. The mutator only stops to shade the
+// roots when a cycle starts and to hand over to the sweeper once marking has drained; the helper
+// thread does all marking and sweeping. Stores into heap containers while marking is in progress
+// hold the collector lock and shade both the overwritten and the stored value, and blocks created
+// during marking start out black, so everything live at the start of the cycle survives it.
+
+#define MARK_SLICE 256
+#define SWEEP_SLICE 1024
+
+enum CollectorPhase { IDLE, MARKING, SWEEPING };
+
+struct Collector
+{
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable done;
+    bool helper_started;
+    bool work_ready;
+    bool marking_done;
+    bool sweeping_done;
+    CollectorPhase phase;
+    std::vector<BlockHeader *> gray;
+    BlockHeader *sweep_cursor;
+    std::size_t next_collection;
+    // set while the evaluator holds the lock through a HeapLock, what it allocates then must not take it again
+    bool mutator_locked;
+};
+
+// never destroyed, the helper thread may still be parked on it while the process exits
+static Collector &collector()
+{
+    static Collector *c = NULL;
+    if(c == NULL)
+    {
+        c = new Collector();
+        c->helper_started = false;
+        c->work_ready = false;
+        c->marking_done = false;
+        c->sweeping_done = false;
+        c->phase = IDLE;
+        c->sweep_cursor = NULL;
+        c->next_collection = INITIAL_COLLECTION_THRESHOLD;
+        c->mutator_locked = false;
+    }
+    return *c;
+}
+
+static void shade(BlockHeader *header)
+{
+    if(!header->marked)
+    {
+        header->marked = true;
+        collector().gray.push_back(header);
+    }
+}
+
+static void shadePointer(void *ptr)
+{
+    if(ptr != NULL && !MyMemory::inArena(ptr))
+        shade(MyMemory::headerOf(ptr));
+}
+
+static void registerBlock(BlockHeader *header)
+{
+    Collector &c = collector();
+    if(c.phase == IDLE)
+    {
+        countBlock(header);
+        return;
+    }
+    std::unique_lock<std::mutex> guard(c.lock, std::defer_lock);
+    if(!c.mutator_locked)
+        guard.lock();
+    header->marked = c.phase == MARKING;
+    countBlock(header);
+}
+
+static void unregisterBlock(BlockHeader *header)
+{
+    Collector &c = collector();
+    if(c.phase == IDLE)
+    {
+        freeBlock(header);
+        return;
+    }
+    std::unique_lock<std::mutex> guard(c.lock, std::defer_lock);
+    if(!c.mutator_locked)
+        guard.lock();
+    if(c.sweep_cursor == header)
+        c.sweep_cursor = header->next;
+    freeBlock(header);
+}
+
+static void markSlices(std::unique_lock<std::mutex> &guard)
+{
+    Collector &c = collector();
+    while(!c.gray.empty())
+    {
+        for(int i = 0; i < MARK_SLICE && !c.gray.empty(); i++)
+        {
+            BlockHeader *header = c.gray.back();
+            c.gray.pop_back();
+            forEachChild(header, [](BlockHeader *child) { shade(child); });
+        }
+        // let a waiting store through between slices
+        guard.unlock();
+        guard.lock();
+    }
+    c.marking_done = true;
+}
+
+static void sweepSlices(std::unique_lock<std::mutex> &guard)
+{
+    Collector &c = collector();
+    while(c.sweep_cursor != NULL)
+    {
+        for(int i = 0; i < SWEEP_SLICE && c.sweep_cursor != NULL; i++)
+        {
+            BlockHeader *header = c.sweep_cursor;
+            c.sweep_cursor = header->next;
+            if(!header->marked && !header->pinned)
+                freeBlock(header);
+            else
+                header->marked = false;
+        }
+        guard.unlock();
+        guard.lock();
+    }
+    c.sweeping_done = true;
+}
+
+static void helperLoop()
+{
+    Collector &c = collector();
+    std::unique_lock<std::mutex> guard(c.lock);
+    while(true)
+    {
+        c.wake.wait(guard, [&c] { return c.work_ready; });
+        c.work_ready = false;
+        if(c.phase == MARKING)
+            markSlices(guard);
+        else if(c.phase == SWEEPING)
+            sweepSlices(guard);
+        c.done.notify_all();
+    }
+}
+
+static void recordPause(std::chrono::steady_clock::time_point start)
+{
+    std::chrono::duration<double, std::micro> pause = std::chrono::steady_clock::now() - start;
+    MyMemory::recordPause(pause.count());
+}
+
+// pause: shade the roots and let the helper start tracing from them
+static void startMarking()
+{
+    Collector &c = collector();
+    auto start = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> guard(c.lock);
+    if(!c.helper_started)
+    {
+        std::thread(helperLoop).detach();
+        c.helper_started = true;
+    }
+    for(auto header: pinnedBlocks())
+        shade(header);
+    forEachExtraRoot([](BlockHeader *header) { shade(header); });
+    c.phase = MARKING;
+    c.marking_done = false;
+    c.work_ready = true;
+    c.wake.notify_one();
+    recordPause(start);
+}
+
+// pause: marking has drained and no store shaded anything since, everything unmarked is garbage
+static bool tryStartSweeping()
+{
+    Collector &c = collector();
+    auto start = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> guard(c.lock);
+    if(!c.marking_done || !c.gray.empty())
+        return false;
+    for(auto it = weakBlocks().begin(); it != weakBlocks().end();)
+    {
+        if((*it)->marked)
+        {
+            ++it;
+            continue;
+        }
+        forgetWeak(*it);
+        it = weakBlocks().erase(it);
+    }
+    c.phase = SWEEPING;
+    c.sweeping_done = false;
+    c.sweep_cursor = heap_blocks;
+    c.work_ready = true;
+    c.wake.notify_one();
+    recordPause(start);
+    return true;
+}
+
+static bool tryFinishCycle()
+{
+    Collector &c = collector();
+    std::lock_guard<std::mutex> guard(c.lock);
+    if(!c.sweeping_done)
+        return false;
+    MyMemory::HeapStats &stats = MyMemory::heapStats();
+    c.phase = IDLE;
+    c.next_collection = std::max<std::size_t>(stats.heap_bytes * 2, INITIAL_COLLECTION_THRESHOLD);
+    stats.collections += 1;
+    return true;
+}
+
+// allocations made under the lock (a table turning into a dictionary makes its key strings) neither poll
+// the collector nor collect at the limit, either would wait on the lock held here
+MyMemory::HeapLock::HeapLock(void *container)
+{
+    Collector &c = collector();
+    locked = false;
+    if(c.phase == MARKING && !c.mutator_locked && container != NULL && !inArena(container))
+    {
+        c.lock.lock();
+        c.mutator_locked = true;
+        was_deferred = limit_deferred;
+        limit_deferred = true;
+        locked = true;
+    }
+}
+
+MyMemory::HeapLock::~HeapLock()
+{
+    if(locked)
+    {
+        limit_deferred = was_deferred;
+        collector().mutator_locked = false;
+        collector().lock.unlock();
+    }
+}
+
+// caller holds a HeapLock on container
+void MyMemory::writeBarrier(void *container, void *old_value, void *new_value)
+{
+    Collector &c = collector();
+    if(c.phase != MARKING || container == NULL || inArena(container))
+        return;
+    shadePointer(old_value);
+    shadePointer(new_value);
+    if(c.marking_done && !c.gray.empty())
+    {
+        c.marking_done = false;
+        c.work_ready = true;
+        c.wake.notify_one();
+    }
+}
+
+// promoted blocks are created black while marking, what they point at must not stay white
+void MyMemory::notePromoted(void *block)
+{
+    Collector &c = collector();
+    if(c.phase != MARKING)
+        return;
+    std::lock_guard<std::mutex> guard(c.lock);
+    forEachChild(headerOf(block), [](BlockHeader *child) { shade(child); });
+    if(c.marking_done && !c.gray.empty())
+    {
+        c.marking_done = false;
+        c.work_ready = true;
+        c.wake.notify_one();
+    }
+}
+
+// the weak blocks marking did not reach are forgotten in the pause that starts the sweep, while the
+// evaluator cannot be looking them up
+void MyMemory::makeWeak(void *ptr, void (*forget)(void *))
+{
+    Collector &c = collector();
+    std::unique_lock<std::mutex> guard(c.lock, std::defer_lock);
+    if(c.phase != IDLE && !c.mutator_locked)
+        guard.lock();
+    BlockHeader *header = headerOf(ptr);
+    header->weak = true;
+    header->finalizer = forget;
+    weakBlocks().insert(header);
+}
+
+// only the owner's reference may lead to the block, so it is shaded like a pointer a store overwrites
+void *MyMemory::readWeak(void *ptr)
+{
+    Collector &c = collector();
+    if(c.phase != MARKING)
+        return ptr;
+    std::unique_lock<std::mutex> guard(c.lock, std::defer_lock);
+    if(!c.mutator_locked)
+        guard.lock();
+    shade(headerOf(ptr));
+    if(c.marking_done && !c.gray.empty())
+    {
+        c.marking_done = false;
+        c.work_ready = true;
+        c.wake.notify_one();
+    }
+    return ptr;
+}
+
+// moves a cycle on without waiting for the helper: starts one once the heap has grown enough since the
+// last, hands a drained marking over to the sweeper, or finishes a done sweep
+static void pollCollection()
+{
+    Collector &c = collector();
+    if(c.phase == IDLE)
+    {
+        if(MyMemory::heapStats().heap_bytes >= c.next_collection)
+            startMarking();
+    }
+    else if(c.phase == MARKING)
+    {
+        tryStartSweeping();
+    }
+    else
+    {
+        tryFinishCycle();
+    }
+}
+
+void MyMemory::safepoint()
+{
+    pollCollection();
+}
+
+// the running line's arena and held values are roots like at any collection started mid-line
+void MyMemory::iterationSafepoint()
+{
+    pollCollection();
+}
+
+// the helper frees blocks while sweeping, the counters are only stable under its lock
+static std::size_t liveHeapBytes()
+{
+    Collector &c = collector();
+    if(c.phase == IDLE)
+        return MyMemory::heapStats().heap_bytes;
+    std::lock_guard<std::mutex> guard(c.lock);
+    return MyMemory::heapStats().heap_bytes;
+}
+
+static void finishCycle()
+{
+    Collector &c = collector();
+    while(c.phase != IDLE)
+    {
+        if(c.phase == MARKING && tryStartSweeping())
+            continue;
+        if(c.phase == SWEEPING && tryFinishCycle())
+            break;
+        std::unique_lock<std::mutex> guard(c.lock);
+        c.done.wait(guard, [&c] { return (c.phase == MARKING && c.marking_done) || (c.phase == SWEEPING && c.sweeping_done); });
+    }
+}
+
+// runs a whole cycle before returning, waiting on the helper instead of polling from safepoints;
+// a cycle already under way was started from a safepoint, so a fresh one follows it to pick up
+// whatever became garbage since
+void MyMemory::collect()
+{
+    Collector &c = collector();
+    if(c.phase != IDLE)
+        finishCycle();
+    startMarking();
+    finishCycle();
+}
+
+const char *MyMemory::memoryMode()
+{
+    return "tracing";
+}
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef __HEAP_HEADER__
+#define __HEAP_HEADER__
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <vector>
+#include "arena.h"
+
+// Blocks promoted out of the arena live on the heap until collect() finds them dead.
+// The default build traces from the pinned roots on a helper thread; building with -DREFCOUNT_MEMORY
+// counts heap-to-heap references instead and frees the blocks whose last reference went away a bounded
+// amount at a time, from the safepoints after it, with trial deletion for closure/env cycles.
+
+namespace MyMemory
+{
+    enum BlockColor { BLACK, GRAY, WHITE, PURPLE };
+
+    // how many of the latest collection pauses are kept for percentiles
+    const std::size_t PAUSE_WINDOW = 4096;
+
+    struct HeapStats
+    {
+        std::size_t heap_bytes;
+        std::size_t peak_heap_bytes;
+        std::size_t heap_limit;
+        // packed element storage outside any block, its owners are finalized on whichever thread frees them
+        std::atomic<long> external_bytes;
+        std::size_t heap_blocks;
+        std::size_t allocations;
+        std::size_t frees;
+        std::size_t collections;
+        // a ring of the last PAUSE_WINDOW pauses, so a long session does not grow it; the total and
+        // the max cover every pause since the last clearPauses()
+        double pauses_us[PAUSE_WINDOW];
+        std::size_t pauses_recorded;
+        double total_pause_us;
+        double max_pause_us;
+    };
+
+    // Thrown from the allocation path when a collection could not bring the heap back under its limit.
+    // The evaluator turns it into an ERROR_OBJ for the line that ran out.
+    class HeapExhausted: public std::bad_alloc
+    {
+        public:
+            const char *what() const noexcept override { return "heap limit exceeded"; }
+    };
+
+    // 0, the default, leaves the heap unbounded; arena temporaries of the running line count against it too
+    void setHeapLimit(std::size_t bytes);
+    // collects when size more bytes would pass the limit, throws HeapExhausted if that was not enough;
+    // held is a heap value nothing but the caller references yet, it survives that collection
+    void reserveHeap(std::size_t size, void *held = NULL);
+    void noteExternalBytes(long delta);
+    // set while a value is promoted, the copies are finished before the limit is checked
+    extern bool limit_deferred;
+
+    void *heapAllocate(std::size_t size, void (*finalizer)(void *), BlockKind kind);
+    void heapRelease(BlockHeader *header);
+
+    void pinBlock(void *ptr);
+    template<typename T>
+    T *pin(T *ptr)
+    {
+        pinBlock(ptr);
+        return ptr;
+    }
+
+    // a weak block is not kept alive by the one reference its owner keeps outside the heap (a table entry);
+    // forget, called on the evaluator's thread once the block is found dead and before it is freed, is
+    // where the owner drops that reference. It takes the place of the block's finalizer.
+    void makeWeak(void *ptr, void (*forget)(void *));
+    // the block found through the owner's reference, ptr itself; must be called before it is stored
+    // anywhere, a collection under way may not have seen it reachable yet
+    void *readWeak(void *ptr);
+
+    // Held around every store into a container that may live on the heap, so the
+    // concurrent marker never walks a map or vector while it is being changed.
+    class HeapLock
+    {
+        public:
+            HeapLock(void *container);
+            ~HeapLock();
+        private:
+            bool locked;
+            bool was_deferred;
+    };
+
+    // must be called, under a HeapLock, on every store of a pointer into a block that may live on the heap
+    void writeBarrier(void *container, void *old_value, void *new_value);
+    void notePromoted(void *block);
+
+    void collect();
+    // called between top-level lines, when nothing outside the heap points into it
+    void safepoint();
+    // called between the iterations of a loop, so a line that runs long collects too
+    void iterationSafepoint();
+    HeapStats &heapStats();
+    void recordPause(double us);
+    void clearPauses();
+    // over the pauses still in the window
+    double pausePercentile(double percentile);
+    const char *memoryMode();
+}
+
+#endif
@@ -0,0 +1,70 @@
+#include "../lexer/lexer.h"
+#include "../parser/parser.h"
+#include "../evaluator/evaluator.h"
+#include "heap.h"
+#include <algorithm>
+#include <chrono>
+
+// Build once as is and once with -DREFCOUNT_MEMORY, the output of both runs is comparable:
+//   g++ -std=c++17 -O2 memory/heap_bench.cpp memory/arena.cpp memory/heap.cpp memory/profiler.cpp memory/promote.cpp
+//       ast/ast.cpp environment/environment.cpp evaluator/*.cpp lexer/lexer.cpp object/array_kernels.cpp object/bigint.cpp
+//       object/array_storage.cpp object/hash_table.cpp object/object.cpp object/persistent.cpp object/string_kernels.cpp
+//       object/utf8.cpp native/native_module.cpp
+//       parser/parser.cpp token/token.cpp -pthread -ldl   (leave out evaluator/evaluator_test.cpp)
+
+std::string globalName(int i)
+{
+    std::string name = "v";
+    do
+    {
+        name.push_back('a' + i % 26);
+        i /= 26;
+    } while(i > 0);
+    return name;
+}
+
+void evalLine(std::string line, MyEnv::Env *env, MyMemory::Arena *arena)
+{
+    MyMemory::current = arena;
+    Lexer *l = New(line);
+    Parser *p = New(l);
+    Node *program = ParseProgram(p);
+    Eval(program, env);
+    delete p;
+    delete l;
+    MyMemory::current = NULL;
+    arena->reset();
+    MyMemory::safepoint();
+}
+
+void BenchCollectionPauses(int live_globals, int lines)
+{
+    MyEnv::Env *env = MyMemory::pin(MyEnv::newEnv());
+    MyMemory::Arena arena;
+
+    evalLine("let cyclic = fn() { let self = fn() { self }; self }", env, &arena);
+    for(int i = 0; i < live_globals; i++)
+        evalLine("let " + globalName(i) + " = [1, 2, 3, \"four\", {\"five\": 5}]", env, &arena);
+
+    MyMemory::HeapStats &stats = MyMemory::heapStats();
+    MyMemory::clearPauses();
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < lines; i++)
+    {
+        std::string name = globalName(i % live_globals);
+        evalLine("let " + name + " = [" + std::to_string(i) + ", \"x\" + \"y\"]; let loop = cyclic()", env, &arena);
+    }
+    std::chrono::duration<double, std::milli> total = std::chrono::steady_clock::now() - start;
+
+    double mean = stats.pauses_recorded != 0 ? stats.total_pause_us / stats.pauses_recorded : 0;
+
+    std::cout << MyMemory::memoryMode() << ": live globals " << live_globals << ", " << lines << " lines in " << total.count() << " ms\n";
+    std::cout << "  pause mean " << mean << " us, p99 " << MyMemory::pausePercentile(99)
+              << " us, max " << stats.max_pause_us << " us, heap blocks " << stats.heap_blocks << "\n";
+}
+
+int main()
+{
+    BenchCollectionPauses(100, 20000);
+    BenchCollectionPauses(5000, 20000);
+}
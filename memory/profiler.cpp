@@ -0,0 +1,165 @@
+#include "profiler.h"
+#include "arena.h"
+#include "../object/object.h"
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <unordered_set>
+
+bool MyMemory::profiling = false;
+
+struct Frame
+{
+    int parent;
+    std::string label;
+};
+
+struct PendingAllocation
+{
+    Object *obj;
+    long site;
+    int stack;
+};
+
+struct SiteCounts
+{
+    long allocated;
+    long survived;
+};
+
+struct Profile
+{
+    long site;
+    int stack;
+    // frame 0 is the top-level line, every other one a call site reached from its parent
+    std::vector<Frame> frames;
+    std::map<std::pair<int, long>, int> frame_ids;
+    std::vector<PendingAllocation> pending;
+    std::unordered_set<Object *> survivors;
+    std::map<std::pair<long, std::string>, SiteCounts> sites;
+    std::map<std::tuple<int, long, std::string>, long> stacks;
+};
+
+static Profile &profile()
+{
+    static Profile *p = NULL;
+    if(p == NULL)
+    {
+        p = new Profile();
+        p->site = 0;
+        p->stack = 0;
+        p->frames.push_back(Frame{-1, "<repl>"});
+    }
+    return *p;
+}
+
+static long siteOf(Node *node)
+{
+    return ((long)node->token.Line << 32) | (unsigned)node->token.Column;
+}
+
+static std::string siteString(long site)
+{
+    return std::to_string(site >> 32) + ":" + std::to_string(site & 0xffffffff);
+}
+
+// nodes the parser gave no position (programs, synthesized blocks) keep their parent's site
+MyMemory::ProfileState MyMemory::enterSite(Node *node, bool call)
+{
+    Profile &p = profile();
+    ProfileState saved = {p.site, p.stack};
+    if(node->token.Line == 0)
+        return saved;
+    p.site = siteOf(node);
+    if(call)
+    {
+        auto key = std::make_pair(p.stack, p.site);
+        auto found = p.frame_ids.find(key);
+        if(found == p.frame_ids.end())
+        {
+            std::string name = node->Function_identifier != NULL && node->Function_identifier->Value != "" ? node->Function_identifier->Value : "fn";
+            p.frames.push_back(Frame{p.stack, name + "@" + siteString(p.site)});
+            found = p.frame_ids.insert(std::make_pair(key, (int)p.frames.size() - 1)).first;
+        }
+        p.stack = found->second;
+    }
+    return saved;
+}
+
+void MyMemory::leaveSite(ProfileState saved)
+{
+    Profile &p = profile();
+    p.site = saved.site;
+    p.stack = saved.stack;
+}
+
+// promotion copies and host allocations are not attributed, only what a line allocates in the arena
+void MyMemory::noteAllocation(Object *obj)
+{
+    if(current == NULL)
+        return;
+    Profile &p = profile();
+    p.pending.push_back(PendingAllocation{obj, p.site, p.stack});
+}
+
+void MyMemory::noteSurvivor(Object *obj)
+{
+    profile().survivors.insert(obj);
+}
+
+// the objects still sit in the arena, so their type is known by now
+void MyMemory::tallyProfiledLine()
+{
+    tallyProfiledAllocations(0);
+    profile().survivors.clear();
+}
+
+std::size_t MyMemory::pendingAllocations()
+{
+    return profile().pending.size();
+}
+
+void MyMemory::tallyProfiledAllocations(std::size_t first)
+{
+    Profile &p = profile();
+    for(std::size_t i = first; i < p.pending.size(); i++)
+    {
+        PendingAllocation &allocation = p.pending[i];
+        std::string type = "DELETED";
+        if(headerOf(allocation.obj)->finalizer != NULL)
+            type = allocation.obj->which_object == "" ? "UNTYPED" : allocation.obj->which_object;
+        SiteCounts &counts = p.sites[std::make_pair(allocation.site, type)];
+        counts.allocated += 1;
+        // the address is free to be reused by the next iteration
+        if(p.survivors.erase(allocation.obj))
+            counts.survived += 1;
+        p.stacks[std::make_tuple(allocation.stack, allocation.site, type)] += 1;
+    }
+    p.pending.resize(first);
+}
+
+void MyMemory::writeProfileReport(std::ostream &out)
+{
+    Profile &p = profile();
+    std::vector<std::pair<std::pair<long, std::string>, SiteCounts>> rows(p.sites.begin(), p.sites.end());
+    std::stable_sort(rows.begin(), rows.end(), [](const auto &a, const auto &b) { return a.second.allocated > b.second.allocated; });
+
+    out << "site\ttype\tallocated\tsurvived\n";
+    for(auto &row: rows)
+        out << siteString(row.first.first) << "\t" << row.first.second << "\t" << row.second.allocated << "\t" << row.second.survived << "\n";
+}
+
+void MyMemory::writeFoldedStacks(std::ostream &out)
+{
+    Profile &p = profile();
+    for(auto &entry: p.stacks)
+    {
+        std::vector<std::string> labels;
+        for(int frame = std::get<0>(entry.first); frame != -1; frame = p.frames[frame].parent)
+            labels.push_back(p.frames[frame].label);
+        std::reverse(labels.begin(), labels.end());
+        for(auto &label: labels)
+            out << label << ";";
+        out << std::get<2>(entry.first) << "@" << siteString(std::get<1>(entry.first)) << " " << entry.second << "\n";
+    }
+}
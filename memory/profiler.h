@@ -0,0 +1,59 @@
+#ifndef __PROFILER_HEADER__
+#define __PROFILER_HEADER__
+
+#include <cstddef>
+#include <iostream>
+
+class Node;
+class Object;
+
+// Opt-in allocation profiler. Every Object allocated while a line is evaluated is attributed to the
+// innermost AST node under evaluation (its source line and column) and to the calls that led there.
+// When the line's arena is reset the objects are tallied by type; those promoted out of it survived.
+
+namespace MyMemory
+{
+    extern bool profiling;
+
+    struct ProfileState
+    {
+        long site;
+        int stack;
+    };
+
+    ProfileState enterSite(Node *node, bool call);
+    void leaveSite(ProfileState saved);
+
+    // held for the duration of a node's evaluation, call sites also open a frame for the folded stacks
+    class ProfileSite
+    {
+        public:
+            ProfileSite(Node *node, bool call = false)
+            {
+                active = profiling;
+                if(active)
+                    saved = enterSite(node, call);
+            }
+            ~ProfileSite()
+            {
+                if(active)
+                    leaveSite(saved);
+            }
+        private:
+            bool active;
+            ProfileState saved;
+    };
+
+    void noteAllocation(Object *obj);
+    void noteSurvivor(Object *obj);
+    void tallyProfiledLine();
+    // a loop iteration about to be rewound tallies what it allocated while the objects are still there
+    std::size_t pendingAllocations();
+    void tallyProfiledAllocations(std::size_t first);
+
+    // sites sorted by objects allocated, and flamegraph.pl input counting objects per stack
+    void writeProfileReport(std::ostream &out);
+    void writeFoldedStacks(std::ostream &out);
+}
+
+#endif
@@ -0,0 +1,226 @@
+#include "arena.h"
+#include "heap.h"
+#include "profiler.h"
+#include "../object/object.h"
+#include <cstring>
+#include <unordered_map>
+
+// arena ropes nested deeper than this are joined into one string instead of copied node by node
+#define MAX_PROMOTED_ROPE_DEPTH 64
+
+// arena block -> its heap copy, so shared and cyclic structures are copied once
+static std::unordered_map<const void *, void *> forwarded;
+static std::vector<void *> promoted_blocks;
+static int rope_depth = 0;
+
+static Object *promoteObjectInto(Object *obj);
+static MyEnv::Env *promoteEnvInto(MyEnv::Env *env);
+
+// nodes already on the heap are shared as they are, so a new version only copies the nodes it made
+static TrieNode *promoteTrie(TrieNode *node)
+{
+    if(node == NULL || !MyMemory::inArena(node))
+        return node;
+    auto found = forwarded.find(node);
+    if(found != forwarded.end())
+        return (TrieNode *)found->second;
+
+    TrieNode *copy = new TrieNode(*node);
+    forwarded[node] = copy;
+    promoted_blocks.push_back(copy);
+
+    for(auto &value: copy->values)
+        value = promoteObjectInto(value);
+    for(auto &child: copy->children)
+        child = promoteTrie(child);
+    for(auto &entry: copy->entries)
+    {
+        entry.key = promoteObjectInto(entry.key);
+        entry.value = promoteObjectInto(entry.value);
+    }
+    return copy;
+}
+
+static Node *promoteNode(Node *node)
+{
+    if(node == NULL || !MyMemory::inArena(node))
+        return node;
+    auto found = forwarded.find(node);
+    if(found != forwarded.end())
+        return (Node *)found->second;
+
+    Node *copy = new Node(*node);
+    forwarded[node] = copy;
+    promoted_blocks.push_back(copy);
+
+    copy->Right_identifier = promoteNode(node->Right_identifier);
+    copy->Left_identifier = promoteNode(node->Left_identifier);
+    copy->Condition_identifier = promoteNode(node->Condition_identifier);
+    copy->Consequence_statement = promoteNode(node->Consequence_statement);
+    copy->Alternative_statement = promoteNode(node->Alternative_statement);
+    copy->Body_statement = promoteNode(node->Body_statement);
+    copy->Function_identifier = promoteNode(node->Function_identifier);
+    copy->Name_identifier = promoteNode(node->Name_identifier);
+    copy->Value_identifier = promoteNode(node->Value_identifier);
+    copy->ReturnValue_identifier = promoteNode(node->ReturnValue_identifier);
+    copy->Expression_identifier = promoteNode(node->Expression_identifier);
+    copy->Left_index = promoteNode(node->Left_index);
+    copy->Right_index = promoteNode(node->Right_index);
+    copy->Index = promoteNode(node->Index);
+    for(auto &child: copy->Node_array)
+        child = promoteNode(child);
+    for(auto &vk: copy->Pairs)
+    {
+        vk.first = promoteNode(vk.first);
+        vk.second = promoteNode(vk.second);
+    }
+    return copy;
+}
+
+static Object *promoteObjectInto(Object *obj)
+{
+    if(obj == NULL || !MyMemory::inArena(obj))
+        return obj;
+    auto found = forwarded.find(obj);
+    if(found != forwarded.end())
+        return (Object *)found->second;
+
+    Object *copy = new Object(*obj);
+    forwarded[obj] = copy;
+    promoted_blocks.push_back(copy);
+    if(MyMemory::profiling)
+        MyMemory::noteSurvivor(obj);
+
+    if(obj->which_object == STRING_OBJ && obj->Value != NULL && !obj->str_interned)
+    {
+        copy->Value = MyMemory::copyString((const char *)obj->Value, obj->str_length);
+        promoted_blocks.push_back(copy->Value);
+    }
+    else if(obj->which_object == STRING_OBJ && obj->rope_left != NULL)
+    {
+        // the pieces already on the heap are shared, so appending to a global string stays O(1);
+        // a rope built by a loop in the arena is joined once rather than recursed through
+        if(rope_depth < MAX_PROMOTED_ROPE_DEPTH)
+        {
+            rope_depth += 1;
+            copy->rope_left = promoteObjectInto(obj->rope_left);
+            copy->rope_right = promoteObjectInto(obj->rope_right);
+            rope_depth -= 1;
+        }
+        else
+        {
+            char *text = (char *)MyMemory::allocate(obj->str_length + 1, NULL, MyMemory::RAW_BLOCK);
+            joinRope(obj, text);
+            text[obj->str_length] = 0;
+            copy->Value = text;
+            copy->rope_left = NULL;
+            copy->rope_right = NULL;
+            promoted_blocks.push_back(text);
+        }
+    }
+    else if(obj->which_object == RETURN_VALUE_OBJ)
+    {
+        copy->Value = promoteObjectInto((Object *)obj->Value);
+    }
+    else if(obj->which_object == BIGINT_OBJ)
+    {
+        std::size_t bytes = obj->big_limbs * sizeof(std::uint32_t);
+        copy->Value = MyMemory::allocate(bytes, NULL, MyMemory::RAW_BLOCK);
+        std::memcpy(copy->Value, obj->Value, bytes);
+        promoted_blocks.push_back(copy->Value);
+    }
+    copy->body = promoteNode(obj->body);
+    for(auto &param: copy->parameters)
+        param = promoteNode(param);
+    copy->env = promoteEnvInto(obj->env);
+    copy->elements.forEachObject([](Object *&ptr) { ptr = promoteObjectInto(ptr); });
+    copy->HashPair.forEachObject([](Object *&ptr) { ptr = promoteObjectInto(ptr); });
+    copy->vector_trie.forEachNode([](TrieNode *&node) { node = promoteTrie(node); });
+    copy->map_trie.forEachNode([](TrieNode *&node) { node = promoteTrie(node); });
+    return copy;
+}
+
+static MyEnv::Env *promoteEnvInto(MyEnv::Env *env)
+{
+    if(env == NULL || !MyMemory::inArena(env))
+        return env;
+    auto found = forwarded.find(env);
+    if(found != forwarded.end())
+        return (MyEnv::Env *)found->second;
+
+    MyEnv::Env *copy = new MyEnv::Env(*env);
+    forwarded[env] = copy;
+    promoted_blocks.push_back(copy);
+
+    copy->store.forEachBinding([](const std::string &, Object *&value) { value = promoteObjectInto(value); });
+    for(auto &value: copy->globals)
+        value = promoteObjectInto(value);
+    copy->outer = promoteEnvInto(env->outer);
+    copy->root = env->root == env ? copy : promoteEnvInto(env->root);
+    return copy;
+}
+
+// the copies are complete now, let the heap account for the references they hold
+static void finishPromotion()
+{
+    for(auto block: promoted_blocks)
+        MyMemory::notePromoted(block);
+    promoted_blocks.clear();
+    forwarded.clear();
+}
+
+Object *MyMemory::promoteObject(Object *obj)
+{
+    if(obj == NULL || !inArena(obj))
+        return obj;
+
+    Arena *arena = current;
+    current = NULL;
+    limit_deferred = true;
+    Object *promoted = promoteObjectInto(obj);
+    finishPromotion();
+    limit_deferred = false;
+    current = arena;
+    reserveHeap(0, promoted);
+    return promoted;
+}
+
+MyEnv::Env *MyMemory::promoteEnv(MyEnv::Env *env)
+{
+    if(env == NULL || !inArena(env))
+        return env;
+
+    Arena *arena = current;
+    current = NULL;
+    limit_deferred = true;
+    MyEnv::Env *promoted = promoteEnvInto(env);
+    finishPromotion();
+    limit_deferred = false;
+    current = arena;
+    reserveHeap(0, promoted);
+    return promoted;
+}
+
+// values nothing can change in place, a copy of one is as good as the value itself
+static bool immutable(Object *obj)
+{
+    const std::string &type = obj->which_object;
+    return type == INTEGER_OBJ || type == FLOAT_OBJ || type == BOOLEAN_OBJ || type == NULL_OBJ || type == BIGINT_OBJ
+        || type == STRING_OBJ || type == VECTOR_OBJ || type == MAP_OBJ;
+}
+
+Object *MyMemory::storable(const void *container, Object *value)
+{
+    if(value == NULL || !inArena(value))
+        return value;
+    if(!inArena(container))
+        return promoteObject(value);
+    if(current == NULL || !current->separated(container, value))
+        return value;
+    if(immutable(value))
+        return promoteObject(value);
+    // an array, hash or closure must stay the one object everything else sees, so it stays where
+    // it is and so does the iteration that made it
+    current->keepIteration(container, value);
+    return value;
+}
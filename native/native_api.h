@@ -0,0 +1,75 @@
+#ifndef __NATIVE_API_HEADER__
+#define __NATIVE_API_HEADER__
+
+// The C interface of native extension modules, loaded by a script with import_native("libfoo.so").
+// A module is a shared object that exports
+//
+//     int native_module_init(const NativeHost *host);
+//
+// which registers its functions through host and returns 0, or anything else to refuse to load.
+// NATIVE_MODULE_INIT(host) { ... } defines it with C linkage and visible, from C and from C++.
+// Modules are written against this header alone; they never see the interpreter's classes, values
+// are opaque and only read or made through the host's functions.
+//
+// The ABI only grows: members are added at the end of NativeHost and api_version goes up, nothing
+// is removed or changed. A module that needs members of version N checks api_version >= N first.
+//
+// A native function gets its arguments, already checked against the arity it was registered with,
+// and returns a value made by the host, or an error from new_error that the script sees like any
+// other. Values are only good until the function returns, a module must not keep them.
+
+#include <stddef.h>
+
+#define NATIVE_API_VERSION 1
+#define NATIVE_INIT_SYMBOL "native_module_init"
+// max_arity of a function taking any number of arguments from min_arity on
+#define NATIVE_VARIADIC -1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// a value of the interpreter, the same pointer its own builtins work with
+typedef struct Object NativeValue;
+
+typedef NativeValue *(*NativeCallback)(NativeValue **arguments, size_t count);
+
+typedef struct NativeHost
+{
+    unsigned int api_version;
+
+    // 0 on success; pure is non-zero for a function without side effects whose result only
+    // depends on its arguments
+    int (*register_function)(const char *name, NativeCallback function, int min_arity, int max_arity, int pure);
+
+    // "INTEGER", "FLOAT", "BOOLEAN", "STRING", "ARRAY", "NULL", ... as the interpreter names them
+    const char *(*type_of)(NativeValue *value);
+    // these return 0 when value is not of their type
+    int (*to_integer)(NativeValue *value, long long *result);
+    int (*to_float)(NativeValue *value, double *result);
+    int (*to_boolean)(NativeValue *value, int *result);
+    // the bytes of a STRING, not necessarily ending in a zero; NULL for anything else
+    const char *(*string_data)(NativeValue *value, size_t *length);
+    // 0 for anything that is not an ARRAY
+    size_t (*array_length)(NativeValue *value);
+    NativeValue *(*array_get)(NativeValue *array, size_t index);
+
+    NativeValue *(*new_integer)(long long value);
+    NativeValue *(*new_float)(double value);
+    NativeValue *(*new_boolean)(int value);
+    NativeValue *(*new_string)(const char *data, size_t length);
+    NativeValue *(*new_array)(NativeValue **elements, size_t count);
+    NativeValue *(*null_value)(void);
+    NativeValue *(*new_error)(const char *message);
+} NativeHost;
+
+typedef int (*NativeModuleInit)(const NativeHost *host);
+
+#ifdef __cplusplus
+}
+#define NATIVE_MODULE_INIT(host) extern "C" __attribute__((visibility("default"))) int native_module_init(const NativeHost *host)
+#else
+#define NATIVE_MODULE_INIT(host) __attribute__((visibility("default"))) int native_module_init(const NativeHost *host)
+#endif
+
+#endif
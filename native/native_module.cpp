@@ -0,0 +1,170 @@
+#include "native_module.h"
+#include "../evaluator/builtins.h"
+#include "../evaluator/evaluator.h"
+#include <dlfcn.h>
+#include <set>
+
+// the interpreter is linked with -ldl where dlopen is not part of libc
+
+static int registerFunction(const char *name, NativeCallback function, int min_arity, int max_arity, int pure)
+{
+    if(name == NULL || function == NULL || min_arity < 0 || (max_arity != NATIVE_VARIADIC && max_arity < min_arity))
+        return -1;
+    registerNative(name, function, min_arity, max_arity, pure != 0);
+    return 0;
+}
+
+static const char *typeOf(NativeValue *value)
+{
+    return value->which_object.c_str();
+}
+
+static int toInteger(NativeValue *value, long long *result)
+{
+    if(value->which_object != INTEGER_OBJ)
+        return 0;
+    *result = (long)value->Value;
+    return 1;
+}
+
+static int toFloat(NativeValue *value, double *result)
+{
+    if(value->which_object != FLOAT_OBJ)
+        return 0;
+    *result = doubleValue(value);
+    return 1;
+}
+
+static int toBoolean(NativeValue *value, int *result)
+{
+    if(value->which_object != BOOLEAN_OBJ)
+        return 0;
+    *result = value->Value != NULL;
+    return 1;
+}
+
+static const char *stringData(NativeValue *value, size_t *length)
+{
+    if(value->which_object != STRING_OBJ)
+        return NULL;
+    *length = value->str_length;
+    return stringValue(value);
+}
+
+static size_t arrayLength(NativeValue *value)
+{
+    return value->which_object == ARRAY_OBJ ? value->elements.length() : 0;
+}
+
+static NativeValue *arrayGet(NativeValue *array, size_t index)
+{
+    if(array->which_object != ARRAY_OBJ || index >= array->elements.length())
+        return nullObject();
+    return array->elements.get(index);
+}
+
+static NativeValue *newInteger(long long value)
+{
+    Object *obj = new Object();
+    obj->which_object = INTEGER_OBJ;
+    long as_long = value;
+    setValLong(obj, as_long);
+    return obj;
+}
+
+static NativeValue *newFloat(double value)
+{
+    Object *obj = new Object();
+    obj->which_object = FLOAT_OBJ;
+    setValDouble(obj, value);
+    return obj;
+}
+
+static NativeValue *newBoolean(int value)
+{
+    return boolObject(value != 0);
+}
+
+static NativeValue *newString(const char *data, size_t length)
+{
+    Object *obj = new Object();
+    obj->which_object = STRING_OBJ;
+    std::string text(data, length);
+    setValStr(obj, text);
+    return obj;
+}
+
+static NativeValue *newArray(NativeValue **elements, size_t count)
+{
+    Object *arr = new Object();
+    arr->which_object = ARRAY_OBJ;
+    arr->elements.assign(std::vector<Object *>(elements, elements + count));
+    return arr;
+}
+
+static NativeValue *nullValue()
+{
+    return nullObject();
+}
+
+static NativeValue *newError(const char *message)
+{
+    return nativeError(message != NULL ? message : "error in native function");
+}
+
+const NativeHost *nativeHost()
+{
+    static const NativeHost host =
+    {
+        NATIVE_API_VERSION,
+        &registerFunction,
+        &typeOf,
+        &toInteger,
+        &toFloat,
+        &toBoolean,
+        &stringData,
+        &arrayLength,
+        &arrayGet,
+        &newInteger,
+        &newFloat,
+        &newBoolean,
+        &newString,
+        &newArray,
+        &nullValue,
+        &newError,
+    };
+    return &host;
+}
+
+std::string loadNativeModule(const std::string &path)
+{
+    static std::set<void *> loaded;
+
+    void *handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if(handle == NULL)
+    {
+        const char *error = dlerror();
+        return "can not load native module " + path + ": " + (error != NULL ? error : "unknown error");
+    }
+    if(loaded.count(handle))
+    {
+        // dlopen counted one more reference to a module that is never unloaded anyway
+        dlclose(handle);
+        return "";
+    }
+
+    NativeModuleInit init = (NativeModuleInit)dlsym(handle, NATIVE_INIT_SYMBOL);
+    if(init == NULL)
+    {
+        dlclose(handle);
+        return "native module " + path + " has no " NATIVE_INIT_SYMBOL;
+    }
+    int status = init(nativeHost());
+    if(status != 0)
+    {
+        // functions it registered before failing stay, so the module does too
+        return "native module " + path + " failed to initialize: " + std::to_string(status);
+    }
+    loaded.insert(handle);
+    return "";
+}
@@ -0,0 +1,14 @@
+#ifndef __NATIVE_MODULE_HEADER__
+#define __NATIVE_MODULE_HEADER__
+
+#include <string>
+#include "native_api.h"
+
+// Loads the shared object at path, dlopen's search rules apply, and runs its native_module_init.
+// Empty when it loaded, why not otherwise. A module is initialized once, loading it again does
+// nothing, and it stays loaded since its functions are registered for good.
+std::string loadNativeModule(const std::string &path);
+// the functions modules get to work with the interpreter's values
+const NativeHost *nativeHost();
+
+#endif
@@ -0,0 +1,252 @@
+#include "array_kernels.h"
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define HAVE_AVX2_KERNELS
+#endif
+
+static __int128 sumScalar(const std::int64_t *data, std::size_t count)
+{
+    __int128 sum = 0;
+    for(std::size_t i = 0; i < count; i++)
+        sum += data[i];
+    return sum;
+}
+
+static std::int64_t minScalar(const std::int64_t *data, std::size_t count)
+{
+    std::int64_t result = data[0];
+    for(std::size_t i = 1; i < count; i++)
+        result = data[i] < result ? data[i] : result;
+    return result;
+}
+
+static std::int64_t maxScalar(const std::int64_t *data, std::size_t count)
+{
+    std::int64_t result = data[0];
+    for(std::size_t i = 1; i < count; i++)
+        result = data[i] > result ? data[i] : result;
+    return result;
+}
+
+#ifdef HAVE_AVX2_KERNELS
+
+static bool haveAvx2()
+{
+    static bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+// AVX2 has no 128 bit lanes, so every value is summed as its low and high 32 bits plus a count of
+// the negative ones; none of the three lane sums can overflow within a chunk of 2^30 values, and
+// low + high * 2^32 - negatives * 2^64 is the exact total
+__attribute__((target("avx2"))) static __int128 sumAvx2(const std::int64_t *data, std::size_t count)
+{
+    const __m256i low_bits = _mm256_set1_epi64x(0xffffffff);
+    const __m256i zero = _mm256_setzero_si256();
+    __int128 sum = 0;
+    std::size_t i = 0;
+    while(i + 4 <= count)
+    {
+        std::size_t stop = count - i > ((std::size_t)1 << 30) ? i + ((std::size_t)1 << 30) : count;
+        __m256i low = zero, high = zero, negatives = zero;
+        for(; i + 4 <= stop; i += 4)
+        {
+            __m256i next = _mm256_loadu_si256((const __m256i *)(data + i));
+            low = _mm256_add_epi64(low, _mm256_and_si256(next, low_bits));
+            high = _mm256_add_epi64(high, _mm256_srli_epi64(next, 32));
+            negatives = _mm256_add_epi64(negatives, _mm256_cmpgt_epi64(zero, next));
+        }
+        std::int64_t low_lanes[4], high_lanes[4], negative_lanes[4];
+        _mm256_storeu_si256((__m256i *)low_lanes, low);
+        _mm256_storeu_si256((__m256i *)high_lanes, high);
+        _mm256_storeu_si256((__m256i *)negative_lanes, negatives);
+        // the negative lanes count down, one -1 per negative value
+        for(int k = 0; k < 4; k++)
+            sum += (__int128)low_lanes[k] + (__int128)high_lanes[k] * ((__int128)1 << 32)
+                   + (__int128)negative_lanes[k] * ((__int128)1 << 64);
+    }
+    return sum + sumScalar(data + i, count - i);
+}
+
+// AVX2 has no 64 bit min or max, a compare picks the lanes to take instead
+template<bool want_min>
+__attribute__((target("avx2"))) static std::int64_t extremeAvx2(const std::int64_t *data, std::size_t count)
+{
+    if(count < 4)
+        return want_min ? minScalar(data, count) : maxScalar(data, count);
+    __m256i best = _mm256_loadu_si256((const __m256i *)data);
+    std::size_t i = 4;
+    for(; i + 4 <= count; i += 4)
+    {
+        __m256i next = _mm256_loadu_si256((const __m256i *)(data + i));
+        __m256i take = want_min ? _mm256_cmpgt_epi64(best, next) : _mm256_cmpgt_epi64(next, best);
+        best = _mm256_blendv_epi8(best, next, take);
+    }
+    std::int64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, best);
+    std::int64_t result = want_min ? minScalar(lanes, 4) : maxScalar(lanes, 4);
+    for(; i < count; i++)
+        result = (want_min ? data[i] < result : data[i] > result) ? data[i] : result;
+    return result;
+}
+
+#endif
+
+__int128 sumInt64(const std::int64_t *data, std::size_t count)
+{
+#ifdef HAVE_AVX2_KERNELS
+    if(haveAvx2())
+        return sumAvx2(data, count);
+#endif
+    return sumScalar(data, count);
+}
+
+std::int64_t minInt64(const std::int64_t *data, std::size_t count)
+{
+#ifdef HAVE_AVX2_KERNELS
+    if(haveAvx2())
+        return extremeAvx2<true>(data, count);
+#endif
+    return minScalar(data, count);
+}
+
+std::int64_t maxInt64(const std::int64_t *data, std::size_t count)
+{
+#ifdef HAVE_AVX2_KERNELS
+    if(haveAvx2())
+        return extremeAvx2<false>(data, count);
+#endif
+    return maxScalar(data, count);
+}
+
+static double doubleAt(const std::int64_t *data, std::size_t i)
+{
+    double value;
+    std::memcpy(&value, data + i, sizeof(double));
+    return value;
+}
+
+static double sumDoublesScalar(const std::int64_t *data, std::size_t count)
+{
+    double sum = 0;
+    for(std::size_t i = 0; i < count; i++)
+        sum += doubleAt(data, i);
+    return sum;
+}
+
+static double dotScalar(const std::int64_t *left, const std::int64_t *right, std::size_t count)
+{
+    double sum = 0;
+    for(std::size_t i = 0; i < count; i++)
+        sum += doubleAt(left, i) * doubleAt(right, i);
+    return sum;
+}
+
+// a nan first stays, later ones are passed over, like the AVX2 min and max instructions do
+template<bool want_min>
+static double extremeDoublesScalar(const std::int64_t *data, std::size_t count)
+{
+    double result = doubleAt(data, 0);
+    for(std::size_t i = 1; i < count; i++)
+    {
+        double next = doubleAt(data, i);
+        result = (want_min ? next < result : next > result) ? next : result;
+    }
+    return result;
+}
+
+#ifdef HAVE_AVX2_KERNELS
+
+__attribute__((target("avx2"))) static double sumDoublesAvx2(const std::int64_t *data, std::size_t count)
+{
+    const double *values = (const double *)data;
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    std::size_t i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(values + i));
+        acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(values + i + 4));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + sumDoublesScalar(data + i, count - i);
+}
+
+__attribute__((target("avx2"))) static double dotAvx2(const std::int64_t *left, const std::int64_t *right, std::size_t count)
+{
+    const double *a = (const double *)left, *b = (const double *)right;
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    std::size_t i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4)));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + dotScalar(left + i, right + i, count - i);
+}
+
+// min_pd and max_pd return their second operand when either is nan
+template<bool want_min>
+__attribute__((target("avx2"))) static double extremeDoublesAvx2(const std::int64_t *data, std::size_t count)
+{
+    if(count < 4)
+        return extremeDoublesScalar<want_min>(data, count);
+    const double *values = (const double *)data;
+    __m256d best = _mm256_loadu_pd(values);
+    std::size_t i = 4;
+    for(; i + 4 <= count; i += 4)
+    {
+        __m256d next = _mm256_loadu_pd(values + i);
+        best = want_min ? _mm256_min_pd(next, best) : _mm256_max_pd(next, best);
+    }
+    std::int64_t lanes[4];
+    _mm256_storeu_pd((double *)lanes, best);
+    double result = extremeDoublesScalar<want_min>(lanes, 4);
+    for(; i < count; i++)
+        result = (want_min ? values[i] < result : values[i] > result) ? values[i] : result;
+    return result;
+}
+
+#endif
+
+double sumFloat64(const std::int64_t *data, std::size_t count)
+{
+#ifdef HAVE_AVX2_KERNELS
+    if(haveAvx2())
+        return sumDoublesAvx2(data, count);
+#endif
+    return sumDoublesScalar(data, count);
+}
+
+double minFloat64(const std::int64_t *data, std::size_t count)
+{
+#ifdef HAVE_AVX2_KERNELS
+    if(haveAvx2())
+        return extremeDoublesAvx2<true>(data, count);
+#endif
+    return extremeDoublesScalar<true>(data, count);
+}
+
+double maxFloat64(const std::int64_t *data, std::size_t count)
+{
+#ifdef HAVE_AVX2_KERNELS
+    if(haveAvx2())
+        return extremeDoublesAvx2<false>(data, count);
+#endif
+    return extremeDoublesScalar<false>(data, count);
+}
+
+double dotFloat64(const std::int64_t *left, const std::int64_t *right, std::size_t count)
+{
+#ifdef HAVE_AVX2_KERNELS
+    if(haveAvx2())
+        return dotAvx2(left, right, count);
+#endif
+    return dotScalar(left, right, count);
+}
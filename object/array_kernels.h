@@ -0,0 +1,22 @@
+#ifndef __ARRAY_KERNELS_HEADER__
+#define __ARRAY_KERNELS_HEADER__
+
+#include <cstddef>
+#include <cstdint>
+
+// Reductions over the packed values of an integer array. On x86-64 they run four lanes at a time
+// with AVX2 when the cpu has it, and fall back to plain loops otherwise.
+// Sums are exact, no count of int64 values that fits in memory can overflow 128 bits; min and max
+// need count > 0.
+__int128 sumInt64(const std::int64_t *data, std::size_t count);
+std::int64_t minInt64(const std::int64_t *data, std::size_t count);
+std::int64_t maxInt64(const std::int64_t *data, std::size_t count);
+
+// The same over packed float arrays, which hold the bits of their doubles. The AVX2 versions add
+// four lanes at a time, so a sum may differ in its last bits from adding left to right.
+double sumFloat64(const std::int64_t *data, std::size_t count);
+double minFloat64(const std::int64_t *data, std::size_t count);
+double maxFloat64(const std::int64_t *data, std::size_t count);
+double dotFloat64(const std::int64_t *left, const std::int64_t *right, std::size_t count);
+
+#endif
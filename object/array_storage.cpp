@@ -0,0 +1,264 @@
+#include "array_storage.h"
+#include "object.h"
+#include "../memory/heap.h"
+#include <cstring>
+
+static ArrayLayout layoutOf(Object *elem)
+{
+    if(elem->which_object == INTEGER_OBJ)
+        return INTEGER_ARRAY;
+    if(elem->which_object == BOOLEAN_OBJ)
+        return BOOLEAN_ARRAY;
+    if(elem->which_object == FLOAT_OBJ)
+        return FLOAT_ARRAY;
+    return GENERIC_ARRAY;
+}
+
+ArrayStorage::ArrayStorage()
+{
+    kind = INTEGER_ARRAY;
+    counted_bytes = 0;
+    base = NULL;
+    offset = 0;
+    view_length = 0;
+}
+
+ArrayStorage::ArrayStorage(const ArrayStorage &other)
+{
+    counted_bytes = 0;
+    base = NULL;
+    *this = other;
+}
+
+// the packed values change hands together with the bytes already counted for them
+ArrayStorage::ArrayStorage(ArrayStorage &&other)
+{
+    kind = other.kind;
+    values = std::move(other.values);
+    objects = std::move(other.objects);
+    counted_bytes = other.counted_bytes;
+    base = other.base;
+    offset = other.offset;
+    view_length = other.view_length;
+    other.values.clear();
+    other.counted_bytes = 0;
+    other.base = NULL;
+}
+
+ArrayStorage &ArrayStorage::operator=(ArrayStorage &&other)
+{
+    if(this == &other)
+        return *this;
+    values.clear();
+    values.shrink_to_fit();
+    account();
+    kind = other.kind;
+    values = std::move(other.values);
+    objects = std::move(other.objects);
+    counted_bytes = other.counted_bytes;
+    base = other.base;
+    offset = other.offset;
+    view_length = other.view_length;
+    other.values.clear();
+    other.counted_bytes = 0;
+    other.base = NULL;
+    return *this;
+}
+
+ArrayStorage &ArrayStorage::operator=(const ArrayStorage &other)
+{
+    if(this == &other)
+        return *this;
+    reservePacked(other.values.size());
+    kind = other.kind;
+    values = other.values;
+    objects = other.objects;
+    base = other.base;
+    offset = other.offset;
+    view_length = other.view_length;
+    account();
+    return *this;
+}
+
+ArrayStorage::~ArrayStorage()
+{
+    values.clear();
+    values.shrink_to_fit();
+    account();
+}
+
+// may collect or throw HeapExhausted, so it runs before anything is changed
+void ArrayStorage::reservePacked(std::size_t count)
+{
+    if(count <= values.capacity())
+        return;
+    MyMemory::reserveHeap((count - values.capacity()) * sizeof(std::int64_t));
+    values.reserve(count);
+    account();
+}
+
+void ArrayStorage::account()
+{
+    std::size_t bytes = values.capacity() * sizeof(std::int64_t);
+    if(bytes != counted_bytes)
+    {
+        MyMemory::noteExternalBytes((long)bytes - (long)counted_bytes);
+        counted_bytes = bytes;
+    }
+}
+
+std::size_t ArrayStorage::length() const
+{
+    if(base != NULL)
+        return view_length;
+    return kind == GENERIC_ARRAY ? objects.size() : values.size();
+}
+
+ArrayLayout ArrayStorage::layout() const
+{
+    return base != NULL ? base->elements.layout() : kind;
+}
+
+const std::int64_t *ArrayStorage::packed() const
+{
+    return base != NULL ? base->elements.packed() + offset : values.data();
+}
+
+// the base array may have been unpacked since the view was made, its own layout decides
+Object *ArrayStorage::get(std::size_t i) const
+{
+    if(base != NULL)
+        return base->elements.get(offset + i);
+    if(kind == GENERIC_ARRAY)
+        return objects[i];
+    if(kind == BOOLEAN_ARRAY)
+        return values[i] ? true_obj : false_obj;
+    if(kind == FLOAT_ARRAY)
+    {
+        double value;
+        std::memcpy(&value, &values[i], sizeof(double));
+        return floatObject(value);
+    }
+    return integerObject((long)values[i]);
+}
+
+// views of views read from the array the first one was made of
+void ArrayStorage::makeView(Object *array, std::size_t first, std::size_t count)
+{
+    const ArrayStorage &source = array->elements;
+    if(source.base != NULL)
+    {
+        first += source.offset;
+        array = source.base;
+    }
+    values.clear();
+    values.shrink_to_fit();
+    account();
+    objects.clear();
+    base = array;
+    offset = first;
+    view_length = count;
+}
+
+ArrayStorage ArrayStorage::materialized() const
+{
+    if(base == NULL)
+        return *this;
+    ArrayStorage copy;
+    copy.kind = layout();
+    if(copy.kind == GENERIC_ARRAY)
+    {
+        auto first = base->elements.objects.begin() + offset;
+        copy.objects.assign(first, first + view_length);
+        return copy;
+    }
+    copy.reservePacked(view_length);
+    copy.values.assign(packed(), packed() + view_length);
+    return copy;
+}
+
+void ArrayStorage::detach()
+{
+    if(base != NULL)
+        *this = materialized();
+}
+
+void ArrayStorage::assign(const std::vector<Object *> &elements)
+{
+    base = NULL;
+    values.clear();
+    objects.clear();
+    kind = elements.empty() ? INTEGER_ARRAY : layoutOf(elements[0]);
+    for(auto elem: elements)
+    {
+        if(layoutOf(elem) != kind)
+        {
+            kind = GENERIC_ARRAY;
+            break;
+        }
+    }
+    if(kind == GENERIC_ARRAY)
+    {
+        objects = elements;
+        return;
+    }
+    reservePacked(elements.size());
+    for(auto elem: elements)
+        values.push_back((long)elem->Value);
+}
+
+std::int64_t *ArrayStorage::assignPacked(ArrayLayout layout, std::size_t count)
+{
+    reservePacked(count);
+    base = NULL;
+    kind = layout;
+    objects.clear();
+    values.assign(count, 0);
+    return values.data();
+}
+
+bool ArrayStorage::fits(Object *elem) const
+{
+    ArrayLayout current = layout();
+    if(current == GENERIC_ARRAY)
+        return true;
+    ArrayLayout elem_kind = layoutOf(elem);
+    return elem_kind == current || (length() == 0 && elem_kind != GENERIC_ARRAY);
+}
+
+// callers check fits() first and adopt() a boxed copy otherwise
+void ArrayStorage::push(Object *elem)
+{
+    detach();
+    if(kind == GENERIC_ARRAY)
+    {
+        objects.push_back(elem);
+        return;
+    }
+    if(values.size() == values.capacity())
+        reservePacked(values.empty() ? 8 : values.size() * 2);
+    if(values.empty())
+        kind = layoutOf(elem);
+    values.push_back((long)elem->Value);
+}
+
+std::vector<Object *> ArrayStorage::boxAll() const
+{
+    if(base == NULL && kind == GENERIC_ARRAY)
+        return objects;
+    std::vector<Object *> boxed;
+    boxed.reserve(length());
+    for(std::size_t i = 0; i < length(); i++)
+        boxed.push_back(get(i));
+    return boxed;
+}
+
+void ArrayStorage::adopt(std::vector<Object *> elements)
+{
+    base = NULL;
+    kind = GENERIC_ARRAY;
+    values.clear();
+    values.shrink_to_fit();
+    account();
+    objects = std::move(elements);
+}
@@ -0,0 +1,88 @@
+#ifndef __ARRAY_STORAGE_HEADER__
+#define __ARRAY_STORAGE_HEADER__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+class Object;
+
+enum ArrayLayout { INTEGER_ARRAY, BOOLEAN_ARRAY, FLOAT_ARRAY, GENERIC_ARRAY };
+
+// Elements of an ARRAY_OBJ. An array holding only integers, only booleans or only floats keeps the
+// raw values packed in an int64 vector, floats as the bits of their doubles; once anything else has to go in, every element is boxed into an Object
+// and the array stays generic. An empty array takes the layout of its first element.
+// Packed storage is not part of any heap block, so it is reported to the heap as external bytes
+// and counts against the heap limit before it grows.
+// A slice is a view of a range of another array and reads through to it. Arrays only ever grow at
+// their end, so the range it covers never changes; changing the slice itself copies the range out first.
+// the double a packed FLOAT_ARRAY value holds the bits of
+inline double packedDouble(std::int64_t bits)
+{
+    double value;
+    std::memcpy(&value, &bits, sizeof(double));
+    return value;
+}
+
+class ArrayStorage
+{
+    public:
+        ArrayStorage();
+        ArrayStorage(const ArrayStorage &other);
+        ArrayStorage(ArrayStorage &&other);
+        ArrayStorage &operator=(const ArrayStorage &other);
+        ArrayStorage &operator=(ArrayStorage &&other);
+        ~ArrayStorage();
+
+        std::size_t length() const;
+        // packed integers and floats are boxed into a new Object, packed booleans are the shared true/false objects
+        Object *get(std::size_t i) const;
+        ArrayLayout layout() const;
+        // length() integers, booleans as 0 and 1, or the bits of doubles, while the layout is packed
+        const std::int64_t *packed() const;
+
+        // count elements of array from first on, bounds are the caller's to check
+        void makeView(Object *array, std::size_t first, std::size_t count);
+        bool isView() const { return base != NULL; }
+        Object *viewBase() const { return base; }
+        // the elements of a view in storage of their own
+        ArrayStorage materialized() const;
+
+        // packs objects when they allow it
+        void assign(const std::vector<Object *> &objects);
+        // count packed values of the given layout, left for the caller to fill in
+        std::int64_t *assignPacked(ArrayLayout layout, std::size_t count);
+        // whether elem can be added without leaving the packed layout
+        bool fits(Object *elem) const;
+        void push(Object *elem);
+
+        // every element as an object; handing them to adopt() makes the array generic
+        std::vector<Object *> boxAll() const;
+        void adopt(std::vector<Object *> objects);
+
+        // element objects of a generic array, or the array a view reads from; packed arrays reference none
+        template<typename F>
+        void forEachObject(F visit)
+        {
+            if(base != NULL)
+                visit(base);
+            for(auto &elem: objects)
+                visit(elem);
+        }
+
+    private:
+        ArrayLayout kind;
+        std::vector<std::int64_t> values;
+        std::vector<Object *> objects;
+        std::size_t counted_bytes;
+        Object *base;
+        std::size_t offset;
+        std::size_t view_length;
+
+        void reservePacked(std::size_t count);
+        void account();
+        void detach();
+};
+
+#endif
@@ -0,0 +1,353 @@
+#include "bigint.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+#define LIMB_BITS 32
+#define DECIMAL_CHUNK 1000000000u
+#define DECIMAL_CHUNK_DIGITS 9
+
+static void trim(Limbs &limbs)
+{
+    while(!limbs.empty() && limbs.back() == 0)
+        limbs.pop_back();
+}
+
+static int compareMagnitudes(const Limbs &left, const Limbs &right)
+{
+    if(left.size() != right.size())
+        return left.size() < right.size() ? -1 : 1;
+    for(std::size_t i = left.size(); i-- > 0;)
+    {
+        if(left[i] != right[i])
+            return left[i] < right[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+static Limbs addMagnitudes(const Limbs &left, const Limbs &right)
+{
+    const Limbs &longer = left.size() >= right.size() ? left : right;
+    const Limbs &shorter = left.size() >= right.size() ? right : left;
+    Limbs sum(longer.size() + 1);
+    std::uint64_t carry = 0;
+    for(std::size_t i = 0; i < longer.size(); i++)
+    {
+        carry += (std::uint64_t)longer[i] + (i < shorter.size() ? shorter[i] : 0);
+        sum[i] = (std::uint32_t)carry;
+        carry >>= LIMB_BITS;
+    }
+    sum[longer.size()] = (std::uint32_t)carry;
+    trim(sum);
+    return sum;
+}
+
+// left - right, left is at least as large as right
+static Limbs subtractMagnitudes(const Limbs &left, const Limbs &right)
+{
+    Limbs difference(left.size());
+    std::int64_t borrow = 0;
+    for(std::size_t i = 0; i < left.size(); i++)
+    {
+        std::int64_t digit = (std::int64_t)left[i] - (i < right.size() ? right[i] : 0) - borrow;
+        borrow = digit < 0;
+        difference[i] = (std::uint32_t)digit;
+    }
+    trim(difference);
+    return difference;
+}
+
+// total += part << (shift limbs); total is long enough for the result
+static void addShifted(Limbs &total, const Limbs &part, std::size_t shift)
+{
+    std::uint64_t carry = 0;
+    std::size_t i = 0;
+    for(; i < part.size() || carry != 0; i++)
+    {
+        carry += (std::uint64_t)total[shift + i] + (i < part.size() ? part[i] : 0);
+        total[shift + i] = (std::uint32_t)carry;
+        carry >>= LIMB_BITS;
+    }
+}
+
+// limbs [from, to) of value, cut to its length
+static Limbs slice(const Limbs &value, std::size_t from, std::size_t to)
+{
+    to = std::min(to, value.size());
+    if(from >= to)
+        return Limbs();
+    Limbs part(value.begin() + from, value.begin() + to);
+    trim(part);
+    return part;
+}
+
+Limbs schoolbookMultiply(const Limbs &left, const Limbs &right)
+{
+    if(left.empty() || right.empty())
+        return Limbs();
+    Limbs product(left.size() + right.size());
+    for(std::size_t i = 0; i < left.size(); i++)
+    {
+        std::uint64_t carry = 0;
+        std::uint64_t digit = left[i];
+        for(std::size_t j = 0; j < right.size(); j++)
+        {
+            carry += digit * right[j] + product[i + j];
+            product[i + j] = (std::uint32_t)carry;
+            carry >>= LIMB_BITS;
+        }
+        product[i + right.size()] = (std::uint32_t)carry;
+    }
+    trim(product);
+    return product;
+}
+
+// (a1 B + a0)(b1 B + b0) = a1 b1 B^2 + ((a0 + a1)(b0 + b1) - a0 b0 - a1 b1) B + a0 b0,
+// three half-size products instead of four
+Limbs multiplyLimbs(const Limbs &left, const Limbs &right)
+{
+    const Limbs &longer = left.size() >= right.size() ? left : right;
+    const Limbs &shorter = left.size() >= right.size() ? right : left;
+    if(shorter.size() < KARATSUBA_THRESHOLD)
+        return schoolbookMultiply(longer, shorter);
+
+    Limbs product(longer.size() + shorter.size() + 1);
+    // too lopsided to split evenly, the longer side is taken in pieces as long as the shorter
+    if(shorter.size() <= longer.size() / 2)
+    {
+        for(std::size_t i = 0; i < longer.size(); i += shorter.size())
+            addShifted(product, multiplyLimbs(slice(longer, i, i + shorter.size()), shorter), i);
+        trim(product);
+        return product;
+    }
+
+    std::size_t half = longer.size() / 2;
+    Limbs longer_low = slice(longer, 0, half), longer_high = slice(longer, half, longer.size());
+    Limbs shorter_low = slice(shorter, 0, half), shorter_high = slice(shorter, half, shorter.size());
+    Limbs low = multiplyLimbs(longer_low, shorter_low);
+    Limbs high = multiplyLimbs(longer_high, shorter_high);
+    Limbs middle = multiplyLimbs(addMagnitudes(longer_low, longer_high), addMagnitudes(shorter_low, shorter_high));
+    middle = subtractMagnitudes(subtractMagnitudes(middle, low), high);
+
+    addShifted(product, low, 0);
+    addShifted(product, middle, half);
+    addShifted(product, high, 2 * half);
+    trim(product);
+    return product;
+}
+
+static Limbs divideBySmall(const Limbs &left, std::uint32_t divisor, std::uint32_t &remainder)
+{
+    Limbs quotient(left.size());
+    std::uint64_t rest = 0;
+    for(std::size_t i = left.size(); i-- > 0;)
+    {
+        rest = (rest << LIMB_BITS) | left[i];
+        quotient[i] = (std::uint32_t)(rest / divisor);
+        rest %= divisor;
+    }
+    trim(quotient);
+    remainder = (std::uint32_t)rest;
+    return quotient;
+}
+
+// Knuth's algorithm D: the divisor is shifted until its top bit is set, so each quotient limb
+// guessed from the top two limbs of the remainder is at most two too large
+static Limbs divideMagnitudes(const Limbs &left, const Limbs &right)
+{
+    if(compareMagnitudes(left, right) < 0)
+        return Limbs();
+    std::uint32_t remainder;
+    if(right.size() == 1)
+        return divideBySmall(left, right[0], remainder);
+
+    int shift = __builtin_clz(right.back());
+    std::size_t n = right.size(), m = left.size() - n;
+    Limbs divisor(n), rest(left.size() + 1);
+    for(std::size_t i = n; i-- > 0;)
+        divisor[i] = (right[i] << shift) | (shift != 0 && i > 0 ? right[i - 1] >> (LIMB_BITS - shift) : 0);
+    rest[left.size()] = shift != 0 ? left.back() >> (LIMB_BITS - shift) : 0;
+    for(std::size_t i = left.size(); i-- > 0;)
+        rest[i] = (left[i] << shift) | (shift != 0 && i > 0 ? left[i - 1] >> (LIMB_BITS - shift) : 0);
+
+    Limbs quotient(m + 1);
+    for(std::size_t j = m + 1; j-- > 0;)
+    {
+        std::uint64_t top = ((std::uint64_t)rest[j + n] << LIMB_BITS) | rest[j + n - 1];
+        std::uint64_t guess = top / divisor[n - 1];
+        std::uint64_t guess_rest = top % divisor[n - 1];
+        while(guess >> LIMB_BITS
+              || guess * divisor[n - 2] > ((guess_rest << LIMB_BITS) | rest[j + n - 2]))
+        {
+            guess -= 1;
+            guess_rest += divisor[n - 1];
+            if(guess_rest >> LIMB_BITS)
+                break;
+        }
+
+        std::uint64_t carry = 0;
+        std::int64_t borrow = 0;
+        for(std::size_t i = 0; i < n; i++)
+        {
+            std::uint64_t product = guess * divisor[i] + carry;
+            carry = product >> LIMB_BITS;
+            std::int64_t digit = (std::int64_t)rest[i + j] - (std::int64_t)(std::uint32_t)product - borrow;
+            borrow = digit < 0;
+            rest[i + j] = (std::uint32_t)digit;
+        }
+        std::int64_t digit = (std::int64_t)rest[j + n] - (std::int64_t)carry - borrow;
+        rest[j + n] = (std::uint32_t)digit;
+
+        // the guess was one too large, the divisor is added back once
+        if(digit < 0)
+        {
+            guess -= 1;
+            std::uint64_t sum = 0;
+            for(std::size_t i = 0; i < n; i++)
+            {
+                sum += (std::uint64_t)rest[i + j] + divisor[i];
+                rest[i + j] = (std::uint32_t)sum;
+                sum >>= LIMB_BITS;
+            }
+            rest[j + n] += (std::uint32_t)sum;
+        }
+        quotient[j] = (std::uint32_t)guess;
+    }
+    trim(quotient);
+    return quotient;
+}
+
+static BigInteger signedValue(bool negative, Limbs magnitude)
+{
+    BigInteger value;
+    value.negative = negative && !magnitude.empty();
+    value.magnitude = std::move(magnitude);
+    return value;
+}
+
+BigInteger bigFromLong(long value)
+{
+    return bigFromInt128(value);
+}
+
+BigInteger bigFromInt128(__int128 value)
+{
+    // the magnitude of the most negative value only fits unsigned
+    unsigned __int128 magnitude = value < 0 ? 0 - (unsigned __int128)value : (unsigned __int128)value;
+    Limbs limbs;
+    for(; magnitude != 0; magnitude >>= LIMB_BITS)
+        limbs.push_back((std::uint32_t)magnitude);
+    return signedValue(value < 0, limbs);
+}
+
+BigInteger bigFromDecimal(const std::string &digits)
+{
+    Limbs magnitude;
+    std::size_t first = digits.size() % DECIMAL_CHUNK_DIGITS;
+    if(first == 0)
+        first = DECIMAL_CHUNK_DIGITS;
+    for(std::size_t i = 0; i < digits.size(); i += first, first = DECIMAL_CHUNK_DIGITS)
+    {
+        std::uint32_t chunk = 0, scale = 1;
+        for(std::size_t k = i; k < i + first; k++)
+        {
+            chunk = chunk * 10 + (digits[k] - '0');
+            scale *= 10;
+        }
+        std::uint64_t carry = chunk;
+        for(auto &limb: magnitude)
+        {
+            carry += (std::uint64_t)limb * scale;
+            limb = (std::uint32_t)carry;
+            carry >>= LIMB_BITS;
+        }
+        if(carry != 0)
+            magnitude.push_back((std::uint32_t)carry);
+    }
+    trim(magnitude);
+    return signedValue(false, magnitude);
+}
+
+bool bigToLong(const BigInteger &value, long &result)
+{
+    if(value.magnitude.size() > 2)
+        return false;
+    unsigned long magnitude = 0;
+    for(std::size_t i = value.magnitude.size(); i-- > 0;)
+        magnitude = (magnitude << LIMB_BITS) | value.magnitude[i];
+    unsigned long limit = value.negative ? (unsigned long)LONG_MAX + 1 : (unsigned long)LONG_MAX;
+    if(magnitude > limit)
+        return false;
+    result = value.negative ? (long)(0ul - magnitude) : (long)magnitude;
+    return true;
+}
+
+std::string bigToDecimal(const BigInteger &value)
+{
+    if(value.magnitude.empty())
+        return "0";
+    std::vector<std::uint32_t> chunks;
+    Limbs rest = value.magnitude;
+    while(!rest.empty())
+    {
+        std::uint32_t chunk;
+        rest = divideBySmall(rest, DECIMAL_CHUNK, chunk);
+        chunks.push_back(chunk);
+    }
+    std::string text = value.negative ? "-" : "";
+    text += std::to_string(chunks.back());
+    for(std::size_t i = chunks.size() - 1; i-- > 0;)
+    {
+        std::string digits = std::to_string(chunks[i]);
+        text.append(DECIMAL_CHUNK_DIGITS - digits.size(), '0');
+        text += digits;
+    }
+    return text;
+}
+
+double bigToDouble(const BigInteger &value)
+{
+    // the top three limbs carry more bits than a double holds, the ones below cannot change it much
+    double result = 0;
+    std::size_t size = value.magnitude.size();
+    std::size_t low = size > 3 ? size - 3 : 0;
+    for(std::size_t i = size; i-- > low;)
+        result = result * 4294967296.0 + value.magnitude[i];
+    result = std::ldexp(result, (int)(low * LIMB_BITS));
+    return value.negative ? -result : result;
+}
+
+int bigCompare(const BigInteger &left, const BigInteger &right)
+{
+    if(left.negative != right.negative)
+        return left.negative ? -1 : 1;
+    int order = compareMagnitudes(left.magnitude, right.magnitude);
+    return left.negative ? -order : order;
+}
+
+BigInteger bigAdd(const BigInteger &left, const BigInteger &right)
+{
+    if(left.negative == right.negative)
+        return signedValue(left.negative, addMagnitudes(left.magnitude, right.magnitude));
+    // opposite signs, the larger magnitude decides the sign
+    if(compareMagnitudes(left.magnitude, right.magnitude) >= 0)
+        return signedValue(left.negative, subtractMagnitudes(left.magnitude, right.magnitude));
+    return signedValue(right.negative, subtractMagnitudes(right.magnitude, left.magnitude));
+}
+
+BigInteger bigSubtract(const BigInteger &left, const BigInteger &right)
+{
+    BigInteger negated = right;
+    negated.negative = !right.negative && !right.magnitude.empty();
+    return bigAdd(left, negated);
+}
+
+BigInteger bigMultiply(const BigInteger &left, const BigInteger &right)
+{
+    return signedValue(left.negative != right.negative, multiplyLimbs(left.magnitude, right.magnitude));
+}
+
+BigInteger bigDivide(const BigInteger &left, const BigInteger &right)
+{
+    return signedValue(left.negative != right.negative, divideMagnitudes(left.magnitude, right.magnitude));
+}
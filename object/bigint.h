@@ -0,0 +1,44 @@
+#ifndef __BIGINT_HEADER__
+#define __BIGINT_HEADER__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// products of two numbers both at least this many limbs long are split Karatsuba style
+#define KARATSUBA_THRESHOLD 40
+
+// Magnitude of a big integer in 32-bit limbs, least significant first, without leading zero limbs;
+// zero has no limbs.
+typedef std::vector<std::uint32_t> Limbs;
+
+// Integers of any size, for the arithmetic that overflows a long. Zero is never negative.
+struct BigInteger
+{
+    bool negative = false;
+    Limbs magnitude;
+};
+
+BigInteger bigFromLong(long value);
+BigInteger bigFromInt128(__int128 value);
+// digits are decimal, with no sign
+BigInteger bigFromDecimal(const std::string &digits);
+// false when value does not fit in a long
+bool bigToLong(const BigInteger &value, long &result);
+std::string bigToDecimal(const BigInteger &value);
+// the nearest double, or inf
+double bigToDouble(const BigInteger &value);
+
+int bigCompare(const BigInteger &left, const BigInteger &right);
+BigInteger bigAdd(const BigInteger &left, const BigInteger &right);
+BigInteger bigSubtract(const BigInteger &left, const BigInteger &right);
+BigInteger bigMultiply(const BigInteger &left, const BigInteger &right);
+// rounds toward zero like long division does; right is not zero
+BigInteger bigDivide(const BigInteger &left, const BigInteger &right);
+
+Limbs multiplyLimbs(const Limbs &left, const Limbs &right);
+// the quadratic product multiplyLimbs falls back to below KARATSUBA_THRESHOLD
+Limbs schoolbookMultiply(const Limbs &left, const Limbs &right);
+
+#endif
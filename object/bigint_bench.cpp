@@ -0,0 +1,117 @@
+#include "bigint.h"
+#include <chrono>
+#include <climits>
+#include <iostream>
+
+// g++ -std=c++17 -O2 object/bigint_bench.cpp object/bigint.cpp
+
+double msSince(std::chrono::steady_clock::time_point start)
+{
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+// the same multiply-add loop on plain longs, on longs checked for overflow the way the evaluator
+// does it, and on big integers throughout
+void BenchSmallIntegers(long iterations)
+{
+    auto start = std::chrono::steady_clock::now();
+    volatile long plain = 1;
+    for(long i = 0; i < iterations; i++)
+        plain = (plain * 3 + i) & 0xffff;
+    double plain_ms = msSince(start);
+
+    start = std::chrono::steady_clock::now();
+    volatile long checked = 1;
+    long overflows = 0;
+    for(long i = 0; i < iterations; i++)
+    {
+        long product, sum;
+        if(__builtin_mul_overflow((long)checked, 3l, &product) || __builtin_add_overflow(product, i, &sum))
+            overflows += 1;
+        else
+            checked = sum & 0xffff;
+    }
+    double checked_ms = msSince(start);
+
+    start = std::chrono::steady_clock::now();
+    BigInteger big = bigFromLong(1), three = bigFromLong(3), mask = bigFromLong(0x10000);
+    long big_iterations = iterations / 100;
+    for(long i = 0; i < big_iterations; i++)
+    {
+        big = bigAdd(bigMultiply(big, three), bigFromLong(i));
+        big = bigSubtract(big, bigMultiply(bigDivide(big, mask), mask));
+    }
+    double big_ns = msSince(start) * 1e6 / big_iterations;
+
+    std::cout << iterations << " small steps: plain " << plain_ms << " ms, checked " << checked_ms << " ms ("
+              << overflows << " overflows), as big integers " << big_ns << " ns/step\n";
+}
+
+BigInteger rangeProduct(long low, long high)
+{
+    if(high - low < 8)
+    {
+        BigInteger product = bigFromLong(1);
+        for(long i = low; i < high; i++)
+            product = bigMultiply(product, bigFromLong(i));
+        return product;
+    }
+    long middle = low + (high - low) / 2;
+    return bigMultiply(rangeProduct(low, middle), rangeProduct(middle, high));
+}
+
+// n! one factor at a time, every product is big by small; then as a product tree, where the halves
+// grow together and the large products go through Karatsuba
+void BenchFactorial(long n)
+{
+    auto start = std::chrono::steady_clock::now();
+    BigInteger linear = bigFromLong(1);
+    for(long i = 2; i <= n; i++)
+        linear = bigMultiply(linear, bigFromLong(i));
+    double linear_ms = msSince(start);
+
+    start = std::chrono::steady_clock::now();
+    BigInteger tree = rangeProduct(2, n + 1);
+    double tree_ms = msSince(start);
+
+    start = std::chrono::steady_clock::now();
+    std::size_t digits = bigToDecimal(tree).size();
+    double print_ms = msSince(start);
+
+    std::cout << n << "! (" << digits << " digits): one by one " << linear_ms << " ms, product tree " << tree_ms
+              << " ms, to decimal " << print_ms << " ms (" << (bigCompare(linear, tree) == 0) << ")\n";
+}
+
+// squaring a number of the given size with the quadratic product and with multiplyLimbs
+void BenchSquare(std::size_t limbs)
+{
+    Limbs value(limbs);
+    std::uint32_t seed = 12345;
+    for(auto &limb: value)
+        limb = seed = seed * 1103515245u + 12345u;
+    value.back() |= 1;
+
+    auto start = std::chrono::steady_clock::now();
+    Limbs schoolbook = schoolbookMultiply(value, value);
+    double schoolbook_ms = msSince(start);
+
+    start = std::chrono::steady_clock::now();
+    Limbs karatsuba = multiplyLimbs(value, value);
+    double karatsuba_ms = msSince(start);
+
+    std::cout << "square of " << limbs << " limbs: schoolbook " << schoolbook_ms << " ms, karatsuba " << karatsuba_ms
+              << " ms (" << (schoolbook == karatsuba) << ")\n";
+}
+
+int main()
+{
+    BenchSmallIntegers(100 * 1000 * 1000);
+    BenchFactorial(1000);
+    BenchFactorial(10000);
+    BenchFactorial(50000);
+    BenchSquare(64);
+    BenchSquare(1000);
+    BenchSquare(10000);
+    BenchSquare(50000);
+}
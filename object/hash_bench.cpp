@@ -0,0 +1,78 @@
+#include "object.h"
+#include "../memory/arena.h"
+#include <chrono>
+
+// g++ -std=c++17 -O2 object/hash_bench.cpp object/array_storage.cpp object/bigint.cpp object/hash_table.cpp object/object.cpp object/utf8.cpp object/persistent.cpp memory/arena.cpp memory/heap.cpp
+//     memory/profiler.cpp memory/promote.cpp ast/ast.cpp environment/environment.cpp token/token.cpp -pthread
+
+double nsPerOp(std::chrono::steady_clock::time_point start, long ops)
+{
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / ops;
+}
+
+// keys are built before the clock starts; lookups go through separate probe objects, as an index
+// expression would, so keys are not just matched by object. Short string keys are interned, their
+// probes share the key's text and hash like a literal would
+void BenchHashTable(long keys, bool string_keys)
+{
+    MyMemory::Arena arena;
+    MyMemory::current = &arena;
+
+    std::vector<Object *> key_objects;
+    std::vector<Object *> probes;
+    for(long i = 0; i < keys; i++)
+    {
+        for(auto objects: {&key_objects, &probes})
+        {
+            Object *key = new Object();
+            if(string_keys)
+            {
+                std::string name = "key" + std::to_string(i);
+                key->which_object = STRING_OBJ;
+                setValStr(key, name);
+            }
+            else
+            {
+                key->which_object = INTEGER_OBJ;
+                setValLong(key, i);
+            }
+            objects->push_back(key);
+        }
+    }
+    Object *value = new Object();
+    value->which_object = INTEGER_OBJ;
+
+    HashTable table;
+    auto start = std::chrono::steady_clock::now();
+    for(long i = 0; i < keys; i++)
+        table.set(GetHashKey(key_objects[i]), key_objects[i], value);
+    double insert_ns = nsPerOp(start, keys);
+
+    long found = 0;
+    // a fixed stride visits the keys out of insertion order
+    long lookups = keys < 1000000 ? 1000000 : keys;
+    start = std::chrono::steady_clock::now();
+    for(long i = 0, k = 0; i < lookups; i++, k = (k + 7919) % keys)
+    {
+        if(table.get(GetHashKey(probes[k]), probes[k]) != NULL)
+            found += 1;
+    }
+    double lookup_ns = nsPerOp(start, lookups);
+
+    std::cout << (string_keys ? "string" : "integer") << " keys " << keys << ": insert " << insert_ns
+              << " ns/op, lookup " << lookup_ns << " ns/op (" << found << "/" << lookups << " found)\n";
+
+    table = HashTable();
+    MyMemory::current = NULL;
+}
+
+int main()
+{
+    long sizes[] = {1000, 100000, 1000000};
+    for(auto keys: sizes)
+    {
+        BenchHashTable(keys, false);
+        BenchHashTable(keys, true);
+    }
+}
@@ -0,0 +1,395 @@
+#include "hash_table.h"
+#include "object.h"
+#include <cstring>
+
+#define EMPTY_SLOT -1
+#define MIN_SLOTS 8
+#define MAX_SHAPE_KEYS 8
+// shapes are never freed, past these the keys are taken to be data rather than a layout and a table
+// that would need one more becomes a dict: a shape leads to at most this many others, and at most
+// this many are made in all
+#define MAX_SHAPE_TRANSITIONS 32
+#define MAX_SHAPES 4096
+
+// murmur3's finalizer, consecutive integers end up spread over the whole table
+static std::uint64_t mix64(std::uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// MurmurHash64A
+std::uint64_t hashString(const char *data, std::size_t length)
+{
+    const std::uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+    std::uint64_t h = 0x9e3779b97f4a7c15ULL ^ (length * m);
+
+    const char *end = data + (length & ~(std::size_t)7);
+    for(; data != end; data += 8)
+    {
+        std::uint64_t k;
+        std::memcpy(&k, data, 8);
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+
+    // byte by byte, a memcpy of a length only known at run time is a library call
+    std::uint64_t tail = 0;
+    for(std::size_t i = 0; i < (length & 7); i++)
+        tail |= (std::uint64_t)(unsigned char)data[i] << (8 * i);
+    if(length & 7)
+    {
+        h ^= tail;
+        h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+// the hash of a value that can be a key, false in hashable if it cannot; matches sameValue, arrays
+// nested past MAX_STRUCTURAL_DEPTH hash by identity like they compare
+static std::uint64_t valueHash(Object *obj, int depth, bool &hashable)
+{
+    if(obj->which_object == INTEGER_OBJ)
+        return mix64((std::uint64_t)(long)obj->Value);
+    if(obj->which_object == BOOLEAN_OBJ)
+        return mix64((bool)obj->Value);
+    if(obj->which_object == STRING_OBJ)
+        return stringHash(obj);
+    if(obj->which_object == BIGINT_OBJ)
+        return hashString((const char *)obj->Value, obj->big_limbs * sizeof(std::uint32_t)) ^ obj->big_negative;
+    if(obj->which_object == NULL_OBJ)
+        return mix64(0x6e756c6c);
+    if(obj->which_object != ARRAY_OBJ)
+    {
+        hashable = false;
+        return 0;
+    }
+    if(depth > MAX_STRUCTURAL_DEPTH)
+        return mix64((std::uint64_t)obj);
+
+    const ArrayStorage &elements = obj->elements;
+    std::size_t length = elements.length();
+    std::uint64_t hash = mix64(length);
+    // floats are no keys, neither are arrays of them
+    if(length > 0 && elements.layout() == FLOAT_ARRAY)
+    {
+        hashable = false;
+        return 0;
+    }
+    // packed integers and booleans hash like the boxed ones would
+    if(length > 0 && elements.layout() != GENERIC_ARRAY)
+    {
+        const std::int64_t *values = elements.packed();
+        for(std::size_t i = 0; i < length; i++)
+            hash = (hash ^ mix64((std::uint64_t)values[i])) * 0x100000001b3ULL;
+        return mix64(hash);
+    }
+    for(std::size_t i = 0; i < length && hashable; i++)
+        hash = (hash ^ valueHash(elements.get(i), depth + 1, hashable)) * 0x100000001b3ULL;
+    return mix64(hash);
+}
+
+HashKeyClass GetHashKey(Object *key)
+{
+    HashKeyClass hash_key;
+    if(key->which_object == ARRAY_OBJ)
+    {
+        bool hashable = true;
+        hash_key.Hash = valueHash(key, 0, hashable);
+        hash_key.Type = hashable ? ARRAY_KEY : NO_KEY;
+    }
+    else if(key->which_object == BIGINT_OBJ)
+    {
+        bool hashable = true;
+        hash_key.Hash = valueHash(key, 0, hashable);
+        hash_key.Type = BIGINT_KEY;
+    }
+    else if(key->which_object == INTEGER_OBJ)
+    {
+        hash_key.Type = INTEGER_KEY;
+        hash_key.Hash = mix64((std::uint64_t)(long)key->Value);
+    }
+    else if(key->which_object == STRING_OBJ)
+    {
+        hash_key.Type = STRING_KEY;
+        hash_key.Hash = stringHash(key);
+    }
+    else if(key->which_object == BOOLEAN_OBJ)
+    {
+        hash_key.Type = BOOLEAN_KEY;
+        hash_key.Hash = mix64((bool)key->Value);
+    }
+    else
+    {
+        hash_key.Type = NO_KEY;
+        hash_key.Hash = 0;
+    }
+    return hash_key;
+}
+
+static Object *freezeKey(Object *key, int depth)
+{
+    // as deep as valueHash looks at contents, below that an array is keyed by its identity anyway
+    if(key->which_object != ARRAY_OBJ || depth > MAX_STRUCTURAL_DEPTH)
+        return key;
+    Object *copy = new Object();
+    copy->which_object = ARRAY_OBJ;
+    copy->elements = key->elements.materialized();
+    if(copy->elements.layout() == GENERIC_ARRAY)
+    {
+        std::vector<Object *> objects = copy->elements.boxAll();
+        for(auto &elem: objects)
+            elem = freezeKey(elem, depth + 1);
+        copy->elements.adopt(objects);
+    }
+    return copy;
+}
+
+Object *frozenKey(Object *key)
+{
+    return freezeKey(key, 0);
+}
+
+bool HashTable::sameKey(const Entry &entry, const HashKeyClass &hash_key, Object *key)
+{
+    if(entry.hash != hash_key.Hash || entry.type != hash_key.Type)
+        return false;
+    // mix64 is a bijection, equal integer hashes mean equal integers and the key object stays untouched
+    if(hash_key.Type == INTEGER_KEY || hash_key.Type == BOOLEAN_KEY || entry.key == key)
+        return true;
+    if(hash_key.Type == STRING_KEY)
+        return sameString(entry.key, key);
+    return sameValue(entry.key, key);
+}
+
+const Shape *Shape::root()
+{
+    static Shape *empty = new Shape();
+    return empty;
+}
+
+int Shape::slotOf(std::uint64_t hash, const char *key) const
+{
+    for(std::size_t i = 0; i < hashes.size(); i++)
+    {
+        if(hashes[i] == hash && keys[i] == key)
+            return (int)i;
+    }
+    return -1;
+}
+
+const Shape *Shape::withKey(const std::string &key, std::uint64_t hash) const
+{
+    static std::size_t shape_count = 1;
+    auto found = transitions.find(key);
+    if(found != transitions.end())
+        return found->second;
+    if(transitions.size() >= MAX_SHAPE_TRANSITIONS || shape_count >= MAX_SHAPES)
+        return NULL;
+    shape_count += 1;
+    Shape *next = new Shape();
+    next->keys = keys;
+    next->keys.push_back(key);
+    next->hashes = hashes;
+    next->hashes.push_back(hash);
+    transitions[key] = next;
+    return next;
+}
+
+HashTable::HashTable()
+{
+    shape = Shape::root();
+    slot_count = 0;
+    slot_width = 1;
+}
+
+Object *HashTable::getKeyOf(const HashTable &other, std::size_t i) const
+{
+    if(other.shape == NULL)
+    {
+        const Entry &entry = other.entries[i];
+        return get(HashKeyClass{entry.type, entry.hash}, entry.key);
+    }
+    const std::string &name = other.shape->keys[i];
+    std::uint64_t hash = other.shape->hashes[i];
+    if(shape != NULL)
+    {
+        int slot = shape->slotOf(hash, name.c_str());
+        return slot >= 0 ? values[slot] : NULL;
+    }
+    // other only has the name, a string object is made up for comparing with this table's keys
+    Object probe;
+    probe.which_object = STRING_OBJ;
+    std::string text = name;
+    setValStr(&probe, text);
+    return get(HashKeyClass{STRING_KEY, hash}, &probe);
+}
+
+std::string HashTable::keyString(Object *key)
+{
+    return key->Inspect(key);
+}
+
+// the shape's keys become string objects, allocated where the table's own objects are being built
+void HashTable::makeDict()
+{
+    for(std::size_t i = 0; i < values.size(); i++)
+    {
+        Object *key = new Object();
+        key->which_object = STRING_OBJ;
+        std::string name = shape->keys[i];
+        setValStr(key, name);
+        entries.push_back(Entry{shape->hashes[i], STRING_KEY, key, values[i]});
+    }
+    shape = NULL;
+    values.clear();
+    values.shrink_to_fit();
+    std::size_t new_slot_count = MIN_SLOTS;
+    while(entries.size() * 3 > new_slot_count * 2)
+        new_slot_count *= 2;
+    rebuild(new_slot_count);
+}
+
+// the slot holding key's position, or the empty slot where it would go; empty slots are -1
+template<typename T>
+std::size_t HashTable::findSlot(const T *slots, const HashKeyClass &hash_key, Object *key) const
+{
+    std::size_t mask = slot_count - 1;
+    std::size_t slot = hash_key.Hash & mask;
+    while(slots[slot] != EMPTY_SLOT && !sameKey(entries[slots[slot]], hash_key, key))
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+// position of key in entries or -1, slot is where it is or would be indexed
+std::int64_t HashTable::lookup(const HashKeyClass &hash_key, Object *key, std::size_t &slot) const
+{
+    const unsigned char *data = index.data();
+    if(slot_width == 1)
+    {
+        slot = findSlot((const std::int8_t *)data, hash_key, key);
+        return ((const std::int8_t *)data)[slot];
+    }
+    if(slot_width == 2)
+    {
+        slot = findSlot((const std::int16_t *)data, hash_key, key);
+        return ((const std::int16_t *)data)[slot];
+    }
+    slot = findSlot((const std::int32_t *)data, hash_key, key);
+    return ((const std::int32_t *)data)[slot];
+}
+
+void HashTable::storeSlot(std::size_t slot, std::size_t position)
+{
+    unsigned char *data = index.data();
+    if(slot_width == 1)
+        ((std::int8_t *)data)[slot] = (std::int8_t)position;
+    else if(slot_width == 2)
+        ((std::int16_t *)data)[slot] = (std::int16_t)position;
+    else
+        ((std::int32_t *)data)[slot] = (std::int32_t)position;
+}
+
+Object *HashTable::get(const HashKeyClass &hash_key, Object *key) const
+{
+    if(shape != NULL)
+    {
+        int slot = hash_key.Type == STRING_KEY ? shape->slotOf(hash_key.Hash, stringValue(key)) : -1;
+        return slot < 0 ? NULL : values[slot];
+    }
+    if(slot_count == 0)
+        return NULL;
+    std::size_t slot;
+    std::int64_t position = lookup(hash_key, key, slot);
+    if(position == EMPTY_SLOT)
+        return NULL;
+    return entries[position].value;
+}
+
+Object *HashTable::getCached(const std::string &key, const Shape *&cached_shape, int &cached_slot) const
+{
+    if(shape == NULL)
+        return NULL;
+    if(shape == cached_shape)
+        return values[cached_slot];
+    int slot = shape->slotOf(hashString(key.c_str(), key.size()), key.c_str());
+    if(slot < 0)
+        return NULL;
+    cached_shape = shape;
+    cached_slot = slot;
+    return values[slot];
+}
+
+Object *HashTable::set(const HashKeyClass &hash_key, Object *key, Object *value)
+{
+    if(shape != NULL && hash_key.Type == STRING_KEY)
+    {
+        int slot = shape->slotOf(hash_key.Hash, stringValue(key));
+        if(slot >= 0)
+        {
+            Object *old_value = values[slot];
+            values[slot] = value;
+            return old_value;
+        }
+        const Shape *next = values.size() < MAX_SHAPE_KEYS ? shape->withKey(stringValue(key), hash_key.Hash) : NULL;
+        if(next != NULL)
+        {
+            shape = next;
+            values.push_back(value);
+            return NULL;
+        }
+    }
+    if(shape != NULL)
+        makeDict();
+
+    // at most two thirds of the slots are in use, so probe sequences stay short
+    if((entries.size() + 1) * 3 > slot_count * 2)
+        rebuild(slot_count == 0 ? MIN_SLOTS : slot_count * 2);
+
+    std::size_t slot;
+    std::int64_t position = lookup(hash_key, key, slot);
+    if(position != EMPTY_SLOT)
+    {
+        Object *old_value = entries[position].value;
+        entries[position].value = value;
+        return old_value;
+    }
+    storeSlot(slot, entries.size());
+    entries.push_back(Entry{hash_key.Hash, hash_key.Type, key, value});
+    return NULL;
+}
+
+// entries never move, only their positions are scattered again over the bigger index,
+// whose slots widen once a position would no longer fit
+void HashTable::rebuild(std::size_t new_slot_count)
+{
+    slot_count = new_slot_count;
+    if(new_slot_count <= 0x80)
+        slot_width = 1;
+    else if(new_slot_count <= 0x8000)
+        slot_width = 2;
+    else
+        slot_width = 4;
+    // every byte 0xff reads back as -1 whatever the width
+    index.assign(slot_count * slot_width, 0xff);
+
+    // entries hold distinct keys, so each probe stops at the first free slot
+    for(std::size_t i = 0; i < entries.size(); i++)
+    {
+        std::size_t slot;
+        lookup(HashKeyClass{entries[i].type, entries[i].hash}, entries[i].key, slot);
+        storeSlot(slot, i);
+    }
+}
@@ -0,0 +1,137 @@
+#ifndef __HASH_TABLE_HEADER__
+#define __HASH_TABLE_HEADER__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Object;
+
+enum HashKeyType { NO_KEY, INTEGER_KEY, STRING_KEY, BOOLEAN_KEY, ARRAY_KEY, BIGINT_KEY };
+
+class HashKeyClass
+{
+    public:
+        HashKeyType Type;
+        std::uint64_t Hash;
+};
+
+// Type is NO_KEY for objects that cannot be used as keys. Arrays are keys when all their elements
+// are, and hash by their contents.
+HashKeyClass GetHashKey(Object *key);
+// What a table stores for key: arrays are copied, nested arrays too, so changing the caller's array
+// afterwards leaves the entry filed, found and printed under the contents it had when inserted.
+// Anything else is immutable and returned as is.
+Object *frozenKey(Object *key);
+std::uint64_t hashString(const char *str, std::size_t length);
+
+// Key layout shared by every small hash built with the same string keys in the same order.
+// Shapes are never freed; adding a key follows, or creates, the transition to the next one, as long
+// as there are not too many already.
+class Shape
+{
+    public:
+        std::vector<std::string> keys;
+        std::vector<std::uint64_t> hashes;
+
+        static const Shape *root();
+        // -1 when the key is not part of this shape
+        int slotOf(std::uint64_t hash, const char *key) const;
+        // NULL when no more shapes may be made, the table becomes a dict instead
+        const Shape *withKey(const std::string &key, std::uint64_t hash) const;
+
+    private:
+        mutable std::unordered_map<std::string, Shape *> transitions;
+};
+
+// A hash starts out as a shape plus a values array, while it holds at most MAX_SHAPE_KEYS string keys
+// and a shape for them can be had.
+// Anything else turns it into a compact dict: entries kept densely in insertion order, so iterating
+// or printing a hash is a linear scan, and a separate open-addressing index of slots holding positions
+// into them. Slots are 1, 2 or 4 bytes wide depending on how many entries they must address. Each entry
+// caches the hash of its key, so a probe only looks at the key object once the 64 bit hashes match.
+class HashTable
+{
+    public:
+        struct Entry
+        {
+            std::uint64_t hash;
+            HashKeyType type;
+            Object *key;
+            Object *value;
+        };
+
+        HashTable();
+
+        static bool sameKey(const Entry &entry, const HashKeyClass &hash_key, Object *key);
+
+        // NULL when the key is not in the table
+        Object *get(const HashKeyClass &hash_key, Object *key) const;
+        // the value that was replaced, NULL when the key is new and was stored too; callers pass
+        // frozenKey(key) so the stored key can not change under the table
+        Object *set(const HashKeyClass &hash_key, Object *key, Object *value);
+        // index sites with a string literal key remember the last shape they saw and the slot of
+        // the key in it; NULL when the table has no shape or no such key, the caller looks it up then
+        Object *getCached(const std::string &key, const Shape *&cached_shape, int &cached_slot) const;
+        std::size_t size() const { return shape != NULL ? values.size() : entries.size(); }
+        // NULL once the table is a dict
+        const Shape *layout() const { return shape; }
+
+        // every key and value object the table references, a shaped table keeps its keys in the shape
+        template<typename F>
+        void forEachObject(F visit)
+        {
+            for(auto &value: values)
+                visit(value);
+            for(auto &entry: entries)
+            {
+                visit(entry.key);
+                visit(entry.value);
+            }
+        }
+
+        // the key at position i in insertion order; a shaped table only has names for them, it returns
+        // NULL and points name at the key's
+        Object *keyAt(std::size_t i, const std::string *&name) const
+        {
+            if(shape != NULL)
+            {
+                name = &shape->keys[i];
+                return NULL;
+            }
+            return entries[i].key;
+        }
+        Object *valueAt(std::size_t i) const { return shape != NULL ? values[i] : entries[i].value; }
+        // the value this table holds under the i-th key of other, NULL when it has none
+        Object *getKeyOf(const HashTable &other, std::size_t i) const;
+
+        // in insertion order
+        template<typename F>
+        void forEachPair(F visit) const
+        {
+            for(std::size_t i = 0; i < values.size(); i++)
+                visit(shape->keys[i], values[i]);
+            for(auto &entry: entries)
+                visit(keyString(entry.key), entry.value);
+        }
+
+    private:
+        const Shape *shape;
+        std::vector<Object *> values;
+        std::vector<Entry> entries;
+        std::vector<unsigned char> index;
+        std::size_t slot_count;
+        int slot_width;
+
+        template<typename T>
+        std::size_t findSlot(const T *slots, const HashKeyClass &hash_key, Object *key) const;
+        std::int64_t lookup(const HashKeyClass &hash_key, Object *key, std::size_t &slot) const;
+        void storeSlot(std::size_t slot, std::size_t position);
+        void rebuild(std::size_t new_slot_count);
+        void makeDict();
+        static std::string keyString(Object *key);
+};
+
+#endif
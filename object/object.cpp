@@ -1,4 +1,63 @@
 #include "object.h"
+#include "../memory/heap.h"
+#include "utf8.h"
+#include <cstdint>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+
+// results shorter than this are copied, a rope node would take more room than the characters
+#define MIN_ROPE_LENGTH 64
+// strings up to this long, literals or made at run time, are interned while the table is below its cap
+#define MAX_INTERNED_LENGTH 32
+#define MAX_INTERNED_STRINGS (64 * 1024)
+// code points between the offsets kept for indexing non-ASCII text
+#define CHAR_INDEX_STRIDE 64
+// integers in this range are made once and shared
+#define SMALL_INTEGER_MIN -128
+#define SMALL_INTEGER_MAX 1023
+
+// set up once, the collector thread may be reading them at any time afterwards
+Object *singletonObject(ObjectType type, long value)
+{
+    Object *obj = MyMemory::pin(new Object());
+    obj->which_object = type;
+    setValLong(obj, value);
+    return obj;
+}
+
+// interned text, each buffer holds its hash after the terminator; the entries are weak, text no
+// string uses any more is dropped by the collection that frees it
+static std::unordered_map<std::string_view, const char *> &internTable()
+{
+    static std::unordered_map<std::string_view, const char *> *table = new std::unordered_map<std::string_view, const char *>();
+    return *table;
+}
+
+static void forgetInterned(void *text)
+{
+    std::size_t length = MyMemory::headerOf(text)->size - 1 - 2 * sizeof(std::uint64_t);
+    internTable().erase(std::string_view((const char *)text, length));
+}
+
+// sets str_chars and str_bytes for the text obj holds
+static void measureString(Object *obj, const char *text)
+{
+    std::size_t chars;
+    obj->str_bytes = !scanUtf8(text, obj->str_length, chars);
+    obj->str_chars = obj->str_bytes ? obj->str_length : chars;
+}
+
+static bool internable(std::size_t length)
+{
+    return length <= MAX_INTERNED_LENGTH && internTable().size() < MAX_INTERNED_STRINGS;
+}
+
+Object *true_obj = singletonObject(BOOLEAN_OBJ, 1);
+Object *false_obj = singletonObject(BOOLEAN_OBJ, 0);
+Object *null_obj = singletonObject(NULL_OBJ, 0);
 
 std::string Object::Inspect(Object *o)
 {
@@ -6,6 +65,14 @@ std::string Object::Inspect(Object *o)
     {
         return std::to_string((long) o->Value);
     }
+    else if(o->which_object == BIGINT_OBJ)
+    {
+        return bigToDecimal(bigValue(o));
+    }
+    else if(o->which_object == FLOAT_OBJ)
+    {
+        return formatDouble(doubleValue(o));
+    }
     else if(o->which_object == BOOLEAN_OBJ)
     {
         return std::to_string((bool)o->Value);
@@ -36,8 +103,7 @@ std::string Object::Inspect(Object *o)
     }
     else if(o->which_object == STRING_OBJ)
     {
-        char *val = (char*) o->Value;
-        return std::string(val);
+        return std::string(stringValue(o), o->str_length);
     }
     else if(o->which_object == BUILTIN_OBJ)
     {
@@ -46,11 +112,18 @@ std::string Object::Inspect(Object *o)
     else if(o->which_object == ARRAY_OBJ)
     {
         std::string el="[";
-        for(int i = 0; i < elements.size(); i++)
+        for(int i = 0; i < elements.length(); i++)
         {
             if(i > 0)
                 el+=",";
-            el += elements[i]->Inspect(elements[i]);
+            if(elements.layout() == INTEGER_ARRAY)
+                el += std::to_string((long)elements.packed()[i]);
+            else if(elements.layout() == BOOLEAN_ARRAY)
+                el += std::to_string((bool)elements.packed()[i]);
+            else if(elements.layout() == FLOAT_ARRAY)
+                el += formatDouble(packedDouble(elements.packed()[i]));
+            else
+                el += elements.get(i)->Inspect(elements.get(i));
         }
         el +="]";
         return el;
@@ -59,65 +132,59 @@ std::string Object::Inspect(Object *o)
     {
         std::string el="{";
         int i = 0;
-        for(auto vk: HashPair)
-        {
+        HashPair.forEachPair([&el, &i](const std::string &key, Object *value) {
             if(i > 0)
                 el+=", ";
-            el += vk.second->Key->Inspect(vk.second->Key) + ":" + vk.second->Inspect((Object* )vk.second->Value);
-            i+=1;    
-        }
+            el += key + ":" + value->Inspect(value);
+            i+=1;
+        });
         el +="}";
         return el;
     }
-    
-}
-
-Object::~Object()
-{
-    delete body;
-    delete env;
-    delete Key;
-    for(auto elem: elements)
-        delete elem;
-    for(auto vk: HashPair)
-        delete vk.second;
-    for(auto param: parameters)
-        delete param;
-    delete Value;
-    parameters.clear();
-    elements.clear();
-    HashPair.clear();
-}
-
-HashKeyClass GetHashKey(Object *key)
-{
-    
-    if(key->which_object == INTEGER_OBJ)
+    else if(o->which_object == VECTOR_OBJ)
     {
-        HashKeyClass *hash_key = new HashKeyClass();
-        hash_key->Type = INTEGER_OBJ;
-        hash_key->Value = (long)key->Value;
-        
-        return *hash_key;
+        std::string el="[";
+        for(std::size_t i = 0; i < vector_trie.size(); i++)
+        {
+            if(i > 0)
+                el+=",";
+            el += vector_trie.get(i)->Inspect(vector_trie.get(i));
+        }
+        el +="]";
+        return el;
+    }
+    else if(o->which_object == MAP_OBJ)
+    {
+        std::string el="{";
+        int i = 0;
+        map_trie.forEachEntry([&el, &i](const HashTable::Entry &entry) {
+            if(i > 0)
+                el+=", ";
+            el += entry.key->Inspect(entry.key) + ":" + entry.value->Inspect(entry.value);
+            i+=1;
+        });
+        el +="}";
+        return el;
     }
-    
-    HashKeyClass *hash_key = new HashKeyClass();
-    hash_key->Type = STRING_OBJ;
-    std::string key_val = std::string((char*)key->Value);
-    std::size_t str_hash = std::hash<std::string>{}(std::string((char *)key->Value));
-    hash_key->Value = static_cast<long>(str_hash);
-
-    return *hash_key;
     
 }
 
 void setValStr(Object *obj, std::string &val)
 {
-    obj->Value = (void*)val.c_str();
+    if(internable(val.size()))
+    {
+        setValInterned(obj, val.c_str(), val.size());
+        return;
+    }
+    obj->Value = (void*)MyMemory::copyString(val.c_str(), val.size());
+    obj->str_length = val.size();
+    measureString(obj, val.c_str());
 }
 void setValStr(Object *obj, char* val)
 {
     obj->Value = (void*)val;
+    obj->str_length = std::strlen(val);
+    measureString(obj, val);
 }
 void setValLong(Object *obj, long &val)
 {
@@ -130,4 +197,402 @@ void setValBool(Object *obj, bool &val)
 void setValObj(Object *obj, Object *val_obj)
 {
     obj->Value = (void *)val_obj;
-}
\ No newline at end of file
+}
+void setValDouble(Object *obj, double val)
+{
+    std::memcpy(&obj->Value, &val, sizeof(double));
+}
+static Object *newNumber(const char *type, void *value)
+{
+    void *ptr = MyMemory::allocate(sizeof(Object), NULL, MyMemory::OBJECT_BLOCK);
+    Object *obj = ::new(ptr) Object();
+    if(MyMemory::profiling)
+        MyMemory::noteAllocation(obj);
+    obj->which_object = type;
+    obj->Value = value;
+    return obj;
+}
+
+// made before any line runs, on the heap
+static Object **smallIntegers()
+{
+    Object **small = new Object *[SMALL_INTEGER_MAX - SMALL_INTEGER_MIN + 1];
+    for(long i = SMALL_INTEGER_MIN; i <= SMALL_INTEGER_MAX; i++)
+        small[i - SMALL_INTEGER_MIN] = singletonObject(INTEGER_OBJ, i);
+    return small;
+}
+
+static Object **small_integers = smallIntegers();
+
+Object *integerObject(long value)
+{
+    if(value < SMALL_INTEGER_MIN || value > SMALL_INTEGER_MAX)
+        return newNumber(INTEGER_OBJ, (void *)value);
+    return small_integers[value - SMALL_INTEGER_MIN];
+}
+
+Object *floatObject(double value)
+{
+    void *bits;
+    std::memcpy(&bits, &value, sizeof(double));
+    return newNumber(FLOAT_OBJ, bits);
+}
+
+double doubleValue(Object *obj)
+{
+    double val;
+    std::memcpy(&val, &obj->Value, sizeof(double));
+    return val;
+}
+double numberValue(Object *obj)
+{
+    if(obj->which_object == FLOAT_OBJ)
+        return doubleValue(obj);
+    if(obj->which_object == INTEGER_OBJ)
+        return (double)(long)obj->Value;
+    return bigToDouble(bigValue(obj));
+}
+std::string formatDouble(double value)
+{
+    // the sign of a nan says nothing about the number it failed to be
+    if(std::isnan(value))
+        return "nan";
+    char text[32];
+    char *end = std::to_chars(text, text + sizeof(text), value).ptr;
+    std::string result(text, end);
+    if(result.find_first_of(".en") == std::string::npos)
+        result += ".0";
+    return result;
+}
+void setValBig(Object *obj, const BigInteger &value)
+{
+    long small;
+    if(bigToLong(value, small))
+    {
+        obj->which_object = INTEGER_OBJ;
+        obj->Value = (void *)small;
+        return;
+    }
+    std::size_t bytes = value.magnitude.size() * sizeof(std::uint32_t);
+    void *limbs = MyMemory::allocate(bytes, NULL, MyMemory::RAW_BLOCK);
+    std::memcpy(limbs, value.magnitude.data(), bytes);
+    obj->which_object = BIGINT_OBJ;
+    obj->Value = limbs;
+    obj->big_limbs = value.magnitude.size();
+    obj->big_negative = value.negative;
+}
+BigInteger bigValue(Object *obj)
+{
+    if(obj->which_object == INTEGER_OBJ)
+        return bigFromLong((long)obj->Value);
+    BigInteger value;
+    const std::uint32_t *limbs = (const std::uint32_t *)obj->Value;
+    value.negative = obj->big_negative;
+    value.magnitude.assign(limbs, limbs + obj->big_limbs);
+    return value;
+}
+Object *concatStrings(Object *left, Object *right)
+{
+    // a rope shares its pieces and can describe far more text than it holds; one that could never
+    // be joined within the heap limit, or at all, fails like the allocation would
+    std::size_t length = left->str_length + right->str_length;
+    std::size_t limit = MyMemory::heapStats().heap_limit;
+    if(length < left->str_length || length > PTRDIFF_MAX || (limit != 0 && length > limit))
+        throw MyMemory::HeapExhausted();
+
+    Object *str = new Object();
+    str->which_object = STRING_OBJ;
+    str->str_length = length;
+    str->str_chars = left->str_chars + right->str_chars;
+    str->rope_left = left;
+    str->rope_right = right;
+    if(internable(length))
+    {
+        char text[MAX_INTERNED_LENGTH];
+        joinRope(str, text);
+        str->rope_left = NULL;
+        str->rope_right = NULL;
+        setValInterned(str, text, length);
+    }
+    else if(str->str_length < MIN_ROPE_LENGTH || left->str_bytes || right->str_bytes)
+    {
+        // bytes that were no character on their own may become one next to the other side's
+        measureString(str, stringValue(str));
+    }
+    return str;
+}
+
+void joinRope(Object *str, char *text)
+{
+    // an explicit stack, ropes built by appending in a loop are as deep as the loop ran
+    std::vector<Object *> pending;
+    pending.push_back(str);
+    std::size_t position = 0;
+    while(!pending.empty())
+    {
+        Object *piece = pending.back();
+        pending.pop_back();
+        if(piece->Value != NULL)
+        {
+            std::memcpy(text + position, piece->Value, piece->str_length);
+            position += piece->str_length;
+        }
+        else if(piece->rope_left != NULL)
+        {
+            pending.push_back(piece->rope_right);
+            pending.push_back(piece->rope_left);
+        }
+    }
+}
+
+const char *stringValue(Object *str)
+{
+    if(str->Value != NULL || str->rope_left == NULL)
+        return (const char *)str->Value;
+
+    // the buffer lives as long as str, a heap string must not point into the arena nor an older arena
+    // string into the loop iteration reading it
+    char *text;
+    if(MyMemory::inArena(str) && MyMemory::current != NULL && !MyMemory::current->outlivesIteration(str))
+    {
+        text = (char *)MyMemory::current->allocate(str->str_length + 1, NULL, MyMemory::RAW_BLOCK);
+    }
+    else
+    {
+        MyMemory::reserveHeap(str->str_length + 1, MyMemory::inArena(str) ? NULL : str);
+        text = (char *)MyMemory::heapAllocate(str->str_length + 1, NULL, MyMemory::RAW_BLOCK);
+    }
+    joinRope(str, text);
+    text[str->str_length] = 0;
+
+    // the pieces are let go, a string read once is not kept twice
+    MyMemory::HeapLock guard(str);
+    MyMemory::writeBarrier(str, NULL, text);
+    MyMemory::writeBarrier(str, str->rope_left, NULL);
+    MyMemory::writeBarrier(str, str->rope_right, NULL);
+    str->Value = (void *)text;
+    str->rope_left = NULL;
+    str->rope_right = NULL;
+    return text;
+}
+
+void setValInterned(Object *obj, const char *text, std::size_t length)
+{
+    const char *interned;
+    auto found = internTable().find(std::string_view(text, length));
+    if(found != internTable().end())
+    {
+        interned = (const char *)MyMemory::readWeak((void *)found->second);
+    }
+    else if(internTable().size() >= MAX_INTERNED_STRINGS)
+    {
+        // past the cap, until collections have dropped enough entries, new text gets a copy of its own
+        obj->Value = (void *)MyMemory::copyString(text, length);
+        obj->str_length = length;
+        measureString(obj, text);
+        return;
+    }
+    else
+    {
+        obj->str_length = length;
+        measureString(obj, text);
+        std::uint64_t hash = hashString(text, length);
+        // code points, or ~0 for text that is not UTF-8
+        std::uint64_t chars = obj->str_bytes ? ~(std::uint64_t)0 : obj->str_chars;
+        char *copy = (char *)MyMemory::heapAllocate(length + 1 + sizeof(hash) + sizeof(chars), NULL, MyMemory::RAW_BLOCK);
+        MyMemory::makeWeak(copy, &forgetInterned);
+        std::memcpy(copy, text, length);
+        copy[length] = 0;
+        std::memcpy(copy + length + 1, &hash, sizeof(hash));
+        std::memcpy(copy + length + 1 + sizeof(hash), &chars, sizeof(chars));
+        internTable()[std::string_view(copy, length)] = copy;
+        interned = copy;
+    }
+    obj->Value = (void *)interned;
+    obj->str_length = length;
+    std::memcpy(&obj->str_hash, interned + length + 1, sizeof(obj->str_hash));
+    obj->str_hashed = true;
+    obj->str_interned = true;
+    std::uint64_t chars;
+    std::memcpy(&chars, interned + length + 1 + sizeof(obj->str_hash), sizeof(chars));
+    obj->str_bytes = chars == ~(std::uint64_t)0;
+    obj->str_chars = obj->str_bytes ? length : chars;
+}
+
+std::uint64_t stringHash(Object *str)
+{
+    if(!str->str_hashed)
+    {
+        str->str_hash = hashString(stringValue(str), str->str_length);
+        str->str_hashed = true;
+    }
+    return str->str_hash;
+}
+
+bool sameString(Object *left, Object *right)
+{
+    if(left->str_interned && right->str_interned)
+        return left->Value == right->Value;
+    if(left->str_length != right->str_length)
+        return false;
+    if(left->str_hashed && right->str_hashed && left->str_hash != right->str_hash)
+        return false;
+    return std::memcmp(stringValue(left), stringValue(right), left->str_length) == 0;
+}
+
+std::size_t charOffset(Object *str, std::size_t i)
+{
+    if(str->str_chars == str->str_length)
+        return i;
+    if(i == str->str_chars)
+        return str->str_length;
+
+    const unsigned char *text = (const unsigned char *)stringValue(str);
+    std::size_t offset = 0;
+    std::size_t skip = i;
+    if(str->str_chars > CHAR_INDEX_STRIDE)
+    {
+        if(str->char_offsets.empty())
+        {
+            str->char_offsets.reserve(str->str_chars / CHAR_INDEX_STRIDE + 1);
+            for(std::size_t at = 0, chars = 0; at < str->str_length; chars++)
+            {
+                if(chars % CHAR_INDEX_STRIDE == 0)
+                    str->char_offsets.push_back(at);
+                at += utf8SequenceLength(text[at]);
+            }
+        }
+        offset = str->char_offsets[i / CHAR_INDEX_STRIDE];
+        skip = i % CHAR_INDEX_STRIDE;
+    }
+    for(; skip > 0; skip--)
+        offset += utf8SequenceLength(text[offset]);
+    return offset;
+}
+
+static bool sameValueAt(Object *left, Object *right, int depth);
+
+// a packed element against a boxed one, without boxing the packed value
+static bool samePacked(ArrayLayout layout, std::int64_t value, Object *obj)
+{
+    if(layout == INTEGER_ARRAY)
+        return obj->which_object == INTEGER_OBJ && (long)obj->Value == value;
+    if(layout == FLOAT_ARRAY)
+        return obj->which_object == FLOAT_OBJ && doubleValue(obj) == packedDouble(value);
+    return obj->which_object == BOOLEAN_OBJ && (bool)obj->Value == (value != 0);
+}
+
+static bool sameArray(Object *left, Object *right, int depth)
+{
+    const ArrayStorage &a = left->elements, &b = right->elements;
+    std::size_t length = a.length();
+    if(length != b.length())
+        return false;
+    if(length == 0)
+        return true;
+
+    ArrayLayout layout_a = a.layout(), layout_b = b.layout();
+    // doubles are compared as numbers, nan is not equal to itself and -0.0 is equal to 0.0
+    if(layout_a == FLOAT_ARRAY && layout_b == FLOAT_ARRAY)
+    {
+        for(std::size_t i = 0; i < length; i++)
+        {
+            if(packedDouble(a.packed()[i]) != packedDouble(b.packed()[i]))
+                return false;
+        }
+        return true;
+    }
+    if(layout_a != GENERIC_ARRAY && layout_b != GENERIC_ARRAY)
+        return layout_a == layout_b && std::memcmp(a.packed(), b.packed(), length * sizeof(std::int64_t)) == 0;
+    if(layout_a != GENERIC_ARRAY || layout_b != GENERIC_ARRAY)
+    {
+        const ArrayStorage &packed = layout_a != GENERIC_ARRAY ? a : b;
+        const ArrayStorage &boxed = layout_a != GENERIC_ARRAY ? b : a;
+        const std::int64_t *values = packed.packed();
+        for(std::size_t i = 0; i < length; i++)
+        {
+            if(!samePacked(packed.layout(), values[i], boxed.get(i)))
+                return false;
+        }
+        return true;
+    }
+    for(std::size_t i = 0; i < length; i++)
+    {
+        if(!sameValueAt(a.get(i), b.get(i), depth + 1))
+            return false;
+    }
+    return true;
+}
+
+static bool sameHash(Object *left, Object *right, int depth)
+{
+    const HashTable &a = left->HashPair, &b = right->HashPair;
+    if(a.size() != b.size())
+        return false;
+    for(std::size_t i = 0; i < a.size(); i++)
+    {
+        Object *value = b.getKeyOf(a, i);
+        if(value == NULL || !sameValueAt(a.valueAt(i), value, depth + 1))
+            return false;
+    }
+    return true;
+}
+
+static bool sameMap(Object *left, Object *right, int depth)
+{
+    if(left->map_trie.size() != right->map_trie.size())
+        return false;
+    bool same = true;
+    left->map_trie.forEachEntry([&](const HashTable::Entry &entry) {
+        if(!same)
+            return;
+        Object *value = right->map_trie.get(HashKeyClass{entry.type, entry.hash}, entry.key);
+        same = value != NULL && sameValueAt(entry.value, value, depth + 1);
+    });
+    return same;
+}
+
+static bool sameValueAt(Object *left, Object *right, int depth)
+{
+    if(left == right)
+        return true;
+    if(left->which_object != right->which_object)
+        return false;
+    if(left->which_object == INTEGER_OBJ || left->which_object == BOOLEAN_OBJ)
+        return left->Value == right->Value;
+    if(left->which_object == FLOAT_OBJ)
+        return doubleValue(left) == doubleValue(right);
+    if(left->which_object == NULL_OBJ)
+        return true;
+    if(left->which_object == STRING_OBJ)
+        return sameString(left, right);
+    if(left->which_object == BIGINT_OBJ)
+        return left->big_negative == right->big_negative && left->big_limbs == right->big_limbs
+               && std::memcmp(left->Value, right->Value, left->big_limbs * sizeof(std::uint32_t)) == 0;
+    if(depth > MAX_STRUCTURAL_DEPTH)
+        return false;
+    if(left->which_object == ARRAY_OBJ)
+        return sameArray(left, right, depth);
+    if(left->which_object == HASH_OBJ)
+        return sameHash(left, right, depth);
+    if(left->which_object == MAP_OBJ)
+        return sameMap(left, right, depth);
+    if(left->which_object == VECTOR_OBJ)
+    {
+        std::size_t length = left->vector_trie.size();
+        if(length != right->vector_trie.size())
+            return false;
+        for(std::size_t i = 0; i < length; i++)
+        {
+            if(!sameValueAt(left->vector_trie.get(i), right->vector_trie.get(i), depth + 1))
+                return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool sameValue(Object *left, Object *right)
+{
+    return sameValueAt(left, right, 0);
+}
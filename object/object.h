@@ -7,8 +7,16 @@
 #include "../token/token.h"
 #include "../ast/ast.h"
 #include "../environment/environment.h"
+#include "../memory/arena.h"
+#include "../memory/profiler.h"
+#include "hash_table.h"
+#include "array_storage.h"
+#include "persistent.h"
+#include "bigint.h"
 
 #define INTEGER_OBJ "INTEGER"
+#define BIGINT_OBJ "BIGINT"
+#define FLOAT_OBJ "FLOAT"
 #define BOOLEAN_OBJ "BOOLEAN"
 #define NULL_OBJ "NULL"
 #define RETURN_VALUE_OBJ "RETURN"
@@ -19,60 +27,105 @@
 #define BUILTIN_OBJ "BUILTIN"
 #define ARRAY_OBJ "ARRAY"
 #define HASH_OBJ "HASH"
+#define VECTOR_OBJ "VECTOR"
+#define MAP_OBJ "MAP"
 
 typedef std::string ObjectType;
 //typedef std::function<Object(std::vector<Object *>)> BultinFunction;
 
 class Env;
 
-class HashKeyClass
-{
-    public:
-        ObjectType Type;
-        long Value;
-
-        bool operator==(const HashKeyClass& m) const
-        {
-            bool xd = Type == m.Type && Value == m.Value;
-            //std::cout << "buna mi giriyo ya, xd: " << xd << "\n";
-            return xd;
-        }
-};
-
-class MyHashFunction
-{
-    public:
-        size_t operator()(const HashKeyClass& m) const
-        {
-            //std::cout << "yoksa buraya mı giriyo la\n";
-            return m.Value + m.Type.length();
-        }
-};
-
 class Object
 {
     public:
-        ~Object();
         std::string which_object;
         std::string error_message;
         void *Value;
         std::vector<Node *> parameters;
         Node *body;
         MyEnv::Env *env;
-        std::vector<Object *> elements;
-        ObjectType type;
+        ArrayStorage elements;
         int value_hash_int;
-        Object *Key;
-        std::unordered_map<HashKeyClass, Object*, MyHashFunction> HashPair;
+        HashTable HashPair;
+        PersistentVector vector_trie;
+        PersistentMap map_trie;
+        // STRING: the length of the text. While Value is NULL the text is rope_left's followed by
+        // rope_right's, it is joined into one buffer the first time it is read
+        std::size_t str_length = 0;
+        Object *rope_left = NULL;
+        Object *rope_right = NULL;
+        // STRING: the hash of the text, once asked for. Interned text is shared by every string with
+        // the same characters, so two interned strings are equal exactly when their Values are
+        std::uint64_t str_hash = 0;
+        bool str_hashed = false;
+        bool str_interned = false;
+        // STRING: code points in the text; text that is not valid UTF-8 is taken a byte at a time
+        std::size_t str_chars = 0;
+        bool str_bytes = false;
+        // STRING: byte offset of every 64th code point, built by the first index into non-ASCII text
+        std::vector<std::size_t> char_offsets;
+        // BIGINT: an integer outside the range of long. Value points at big_limbs limbs of its
+        // magnitude, least significant first; results that fit in a long again are INTEGERs
+        std::size_t big_limbs = 0;
+        bool big_negative = false;
 
         std::string Inspect(Object *o);
+
+        static void *operator new(std::size_t size)
+        {
+            void *ptr = MyMemory::allocate(size, &MyMemory::destroy<Object>, MyMemory::OBJECT_BLOCK);
+            if(MyMemory::profiling)
+                MyMemory::noteAllocation((Object *)ptr);
+            return ptr;
+        }
+        static void operator delete(void *ptr) { MyMemory::release(ptr); }
 };
 
+// booleans and null are shared, comparisons between them are by identity
+extern Object *true_obj;
+extern Object *false_obj;
+extern Object *null_obj;
+Object *singletonObject(ObjectType type, long value);
+
 void setValStr(Object *obj, std::string &val);
 void setValStr(Object *obj, char* val);
 void setValLong(Object *obj, long &val);
 void setValBool(Object *obj, bool &val);
 void setValObj(Object *obj, Object *val_obj);
-HashKeyClass GetHashKey(Object *key);
+// FLOAT: the bits of the double are kept in Value itself, there is nothing behind it
+void setValDouble(Object *obj, double val);
+// INTEGER and FLOAT results. Small integers are shared like the booleans and must not be written to;
+// other numbers own nothing, so no destructor is registered for them
+Object *integerObject(long value);
+Object *floatObject(double value);
+double doubleValue(Object *obj);
+// an INTEGER, BIGINT or FLOAT as a double
+double numberValue(Object *obj);
+// the shortest text that reads back as value, whole numbers keep a ".0" to show they are floats
+std::string formatDouble(double value);
+// makes the new object obj the INTEGER value is, or the BIGINT when it does not fit in a long
+void setValBig(Object *obj, const BigInteger &value);
+// the value of an INTEGER or BIGINT
+BigInteger bigValue(Object *obj);
+
+// points obj at the one copy of text kept for all strings equal to it while any string uses it;
+// setValStr interns short strings this way. Once the table is full, text not in it yet is copied instead
+void setValInterned(Object *obj, const char *text, std::size_t length);
+// left + right; long results share both strings instead of copying them
+Object *concatStrings(Object *left, Object *right);
+// the NUL-terminated text of a STRING object
+const char *stringValue(Object *str);
+// writes the text of str, str_length characters, to text; used where the joined buffer is made
+void joinRope(Object *str, char *text);
+// hashString of the text, computed once per object
+std::uint64_t stringHash(Object *str);
+// byte offset of code point i, i may be str_chars
+std::size_t charOffset(Object *str, std::size_t i);
+bool sameString(Object *left, Object *right);
+// == on any two values: containers are equal when their contents are, anything else only to itself.
+// Arrays nested deeper than MAX_STRUCTURAL_DEPTH compare by identity, which also ends the walk
+// through an array that holds itself; GetHashKey hashes them the same way.
+#define MAX_STRUCTURAL_DEPTH 64
+bool sameValue(Object *left, Object *right);
 
 #endif
\ No newline at end of file
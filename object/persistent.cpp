@@ -0,0 +1,264 @@
+#include "persistent.h"
+#include "object.h"
+
+#define BITS 5
+#define WIDTH (1 << BITS)
+#define MASK (WIDTH - 1)
+// past the last fragment of a 64 bit hash, keys whose hashes are equal share one node
+#define HASH_BITS 64
+
+PersistentVector::PersistentVector()
+{
+    count = 0;
+    shift = BITS;
+    root = NULL;
+    tail = NULL;
+}
+
+// index of the first element held in the tail
+std::size_t PersistentVector::tailOffset() const
+{
+    if(count < WIDTH)
+        return 0;
+    return ((count - 1) >> BITS) << BITS;
+}
+
+Object *PersistentVector::get(std::size_t i) const
+{
+    if(i >= tailOffset())
+        return tail->values[i & MASK];
+    const TrieNode *node = root;
+    for(int level = shift; level > 0; level -= BITS)
+        node = node->children[(i >> level) & MASK];
+    return node->values[i & MASK];
+}
+
+// a chain of single-child nodes from level down to leaf
+static TrieNode *newPath(int level, TrieNode *leaf)
+{
+    if(level == 0)
+        return leaf;
+    TrieNode *node = new TrieNode();
+    node->children.push_back(newPath(level - BITS, leaf));
+    return node;
+}
+
+// copies of the nodes from parent down to where the full tail goes
+TrieNode *PersistentVector::pushTail(int level, TrieNode *parent, TrieNode *leaf) const
+{
+    std::size_t sub = ((count - 1) >> level) & MASK;
+    TrieNode *inserted;
+    if(level == BITS)
+        inserted = leaf;
+    else if(parent != NULL && sub < parent->children.size())
+        inserted = pushTail(level - BITS, parent->children[sub], leaf);
+    else
+        inserted = newPath(level - BITS, leaf);
+
+    TrieNode *node = parent != NULL ? new TrieNode(*parent) : new TrieNode();
+    if(sub < node->children.size())
+        node->children[sub] = inserted;
+    else
+        node->children.push_back(inserted);
+    return node;
+}
+
+PersistentVector PersistentVector::push(Object *elem) const
+{
+    PersistentVector pushed = *this;
+    pushed.count = count + 1;
+    if(count - tailOffset() < WIDTH)
+    {
+        pushed.tail = tail != NULL ? new TrieNode(*tail) : new TrieNode();
+        pushed.tail->values.push_back(elem);
+        return pushed;
+    }
+
+    // the tail is full, it moves into the trie and a new one starts
+    if((count >> BITS) > ((std::size_t)1 << shift))
+    {
+        TrieNode *new_root = new TrieNode();
+        new_root->children.push_back(root);
+        new_root->children.push_back(newPath(shift, tail));
+        pushed.root = new_root;
+        pushed.shift = shift + BITS;
+    }
+    else
+    {
+        pushed.root = pushTail(shift, root, tail);
+    }
+    pushed.tail = new TrieNode();
+    pushed.tail->values.push_back(elem);
+    return pushed;
+}
+
+static TrieNode *assocPath(int level, const TrieNode *node, std::size_t i, Object *elem)
+{
+    TrieNode *copy = new TrieNode(*node);
+    if(level == 0)
+        copy->values[i & MASK] = elem;
+    else
+        copy->children[(i >> level) & MASK] = assocPath(level - BITS, node->children[(i >> level) & MASK], i, elem);
+    return copy;
+}
+
+PersistentVector PersistentVector::set(std::size_t i, Object *elem) const
+{
+    if(i == count)
+        return push(elem);
+    PersistentVector updated = *this;
+    if(i >= tailOffset())
+    {
+        updated.tail = new TrieNode(*tail);
+        updated.tail->values[i & MASK] = elem;
+    }
+    else
+    {
+        updated.root = assocPath(shift, root, i, elem);
+    }
+    return updated;
+}
+
+PersistentMap::PersistentMap()
+{
+    count = 0;
+    root = NULL;
+}
+
+static int fragmentOf(std::uint64_t hash, int shift)
+{
+    return (int)((hash >> shift) & MASK);
+}
+
+// position among the entries or children whose fragments come before bit
+static int indexOf(std::uint32_t map, std::uint32_t bit)
+{
+    return __builtin_popcount(map & (bit - 1));
+}
+
+Object *PersistentMap::get(const HashKeyClass &hash_key, Object *key) const
+{
+    const TrieNode *node = root;
+    for(int shift = 0; node != NULL; shift += BITS)
+    {
+        if(shift >= HASH_BITS)
+        {
+            for(auto &entry: node->entries)
+            {
+                if(HashTable::sameKey(entry, hash_key, key))
+                    return entry.value;
+            }
+            return NULL;
+        }
+        std::uint32_t bit = 1u << fragmentOf(hash_key.Hash, shift);
+        if(node->entry_map & bit)
+        {
+            const HashTable::Entry &entry = node->entries[indexOf(node->entry_map, bit)];
+            return HashTable::sameKey(entry, hash_key, key) ? entry.value : NULL;
+        }
+        if(!(node->child_map & bit))
+            return NULL;
+        node = node->children[indexOf(node->child_map, bit)];
+    }
+    return NULL;
+}
+
+// a node holding two entries whose hashes agree up to shift
+static TrieNode *mergeEntries(const HashTable::Entry &first, const HashTable::Entry &second, int shift)
+{
+    TrieNode *node = new TrieNode();
+    if(shift >= HASH_BITS)
+    {
+        node->entries.push_back(first);
+        node->entries.push_back(second);
+        return node;
+    }
+    int first_fragment = fragmentOf(first.hash, shift);
+    int second_fragment = fragmentOf(second.hash, shift);
+    if(first_fragment == second_fragment)
+    {
+        node->child_map = 1u << first_fragment;
+        node->children.push_back(mergeEntries(first, second, shift + BITS));
+        return node;
+    }
+    node->entry_map = (1u << first_fragment) | (1u << second_fragment);
+    node->entries.push_back(first_fragment < second_fragment ? first : second);
+    node->entries.push_back(first_fragment < second_fragment ? second : first);
+    return node;
+}
+
+// the copy of node with entry stored, added tells whether the key was new
+static TrieNode *assocEntry(const TrieNode *node, const HashTable::Entry &entry, int shift, bool &added)
+{
+    if(node == NULL)
+    {
+        TrieNode *leaf = new TrieNode();
+        if(shift < HASH_BITS)
+            leaf->entry_map = 1u << fragmentOf(entry.hash, shift);
+        leaf->entries.push_back(entry);
+        added = true;
+        return leaf;
+    }
+
+    HashKeyClass hash_key{entry.type, entry.hash};
+    if(shift >= HASH_BITS)
+    {
+        TrieNode *copy = new TrieNode(*node);
+        for(auto &existing: copy->entries)
+        {
+            if(HashTable::sameKey(existing, hash_key, entry.key))
+            {
+                existing.value = entry.value;
+                return copy;
+            }
+        }
+        copy->entries.push_back(entry);
+        added = true;
+        return copy;
+    }
+
+    std::uint32_t bit = 1u << fragmentOf(entry.hash, shift);
+    if(node->child_map & bit)
+    {
+        int index = indexOf(node->child_map, bit);
+        TrieNode *child = assocEntry(node->children[index], entry, shift + BITS, added);
+        TrieNode *copy = new TrieNode(*node);
+        copy->children[index] = child;
+        return copy;
+    }
+    if(node->entry_map & bit)
+    {
+        int index = indexOf(node->entry_map, bit);
+        const HashTable::Entry &existing = node->entries[index];
+        if(HashTable::sameKey(existing, hash_key, entry.key))
+        {
+            TrieNode *copy = new TrieNode(*node);
+            copy->entries[index].value = entry.value;
+            return copy;
+        }
+        // two keys on one fragment, both move down into a new subtree
+        TrieNode *child = mergeEntries(existing, entry, shift + BITS);
+        TrieNode *copy = new TrieNode(*node);
+        copy->entries.erase(copy->entries.begin() + index);
+        copy->entry_map &= ~bit;
+        copy->child_map |= bit;
+        copy->children.insert(copy->children.begin() + indexOf(copy->child_map, bit), child);
+        added = true;
+        return copy;
+    }
+    TrieNode *copy = new TrieNode(*node);
+    copy->entries.insert(copy->entries.begin() + indexOf(node->entry_map, bit), entry);
+    copy->entry_map |= bit;
+    added = true;
+    return copy;
+}
+
+PersistentMap PersistentMap::set(const HashKeyClass &hash_key, Object *key, Object *value) const
+{
+    bool added = false;
+    PersistentMap updated = *this;
+    updated.root = assocEntry(root, HashTable::Entry{hash_key.Hash, hash_key.Type, key, value}, 0, added);
+    if(added)
+        updated.count += 1;
+    return updated;
+}
@@ -0,0 +1,102 @@
+#ifndef __PERSISTENT_HEADER__
+#define __PERSISTENT_HEADER__
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "hash_table.h"
+#include "../memory/arena.h"
+
+// A node of a persistent vector or map. Nodes are never changed once they are reachable from a
+// VECTOR or MAP object, every update copies the nodes on the path it touches and shares the rest,
+// so versions of a collection cost O(log32 n) new nodes each.
+class TrieNode
+{
+    public:
+        // vector leaves: up to 32 elements
+        std::vector<Object *> values;
+        // vector inner nodes: up to 32 subtrees; map nodes: subtrees in fragment order
+        std::vector<TrieNode *> children;
+        // map nodes: entries in fragment order, or every entry of a node past the last hash bit
+        std::vector<HashTable::Entry> entries;
+        // map nodes: which 5 bit hash fragments are held as entries, and which as subtrees
+        std::uint32_t entry_map = 0;
+        std::uint32_t child_map = 0;
+
+        static void *operator new(std::size_t size)
+        {
+            return MyMemory::allocate(size, &MyMemory::destroy<TrieNode>, MyMemory::TRIE_BLOCK);
+        }
+        static void operator delete(void *ptr) { MyMemory::release(ptr); }
+};
+
+// 32-way trie with the last, partly filled leaf kept aside as the tail, so most pushes copy only it.
+class PersistentVector
+{
+    public:
+        PersistentVector();
+
+        std::size_t size() const { return count; }
+        Object *get(std::size_t i) const;
+        PersistentVector push(Object *elem) const;
+        // i may be size(), which pushes
+        PersistentVector set(std::size_t i, Object *elem) const;
+
+        template<typename F>
+        void forEachNode(F visit)
+        {
+            visit(root);
+            visit(tail);
+        }
+
+    private:
+        std::size_t count;
+        int shift;
+        TrieNode *root;
+        TrieNode *tail;
+
+        std::size_t tailOffset() const;
+        TrieNode *pushTail(int level, TrieNode *parent, TrieNode *leaf) const;
+};
+
+// Hash array mapped trie over the same keys and hashes as HASH objects; pairs come out grouped by
+// hash rather than in insertion order.
+class PersistentMap
+{
+    public:
+        PersistentMap();
+
+        std::size_t size() const { return count; }
+        // NULL when the key is not in the map
+        Object *get(const HashKeyClass &hash_key, Object *key) const;
+        // key as given by frozenKey
+        PersistentMap set(const HashKeyClass &hash_key, Object *key, Object *value) const;
+
+        template<typename F>
+        void forEachNode(F visit)
+        {
+            visit(root);
+        }
+
+        template<typename F>
+        void forEachEntry(F visit) const
+        {
+            if(root != NULL)
+                visitEntries(root, visit);
+        }
+
+    private:
+        std::size_t count;
+        TrieNode *root;
+
+        template<typename F>
+        static void visitEntries(const TrieNode *node, F &visit)
+        {
+            for(auto &entry: node->entries)
+                visit(entry);
+            for(auto child: node->children)
+                visitEntries(child, visit);
+        }
+};
+
+#endif
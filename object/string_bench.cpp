@@ -0,0 +1,124 @@
+#include "object.h"
+#include "string_kernels.h"
+#include "../memory/arena.h"
+#include <chrono>
+#include <cstring>
+
+// g++ -std=c++17 -O2 object/string_bench.cpp object/array_kernels.cpp object/array_storage.cpp object/bigint.cpp object/hash_table.cpp
+//     object/object.cpp object/persistent.cpp object/string_kernels.cpp object/utf8.cpp memory/arena.cpp memory/heap.cpp
+//     memory/profiler.cpp memory/promote.cpp ast/ast.cpp environment/environment.cpp token/token.cpp -pthread
+
+double msSince(std::chrono::steady_clock::time_point start)
+{
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+Object *newPiece(std::string text)
+{
+    Object *piece = new Object();
+    piece->which_object = STRING_OBJ;
+    setValStr(piece, text);
+    return piece;
+}
+
+// what s = s + piece did before ropes: every step copies everything built so far
+void BenchCopyingAppend(std::size_t target, std::size_t piece_length)
+{
+    MyMemory::Arena arena;
+    MyMemory::current = &arena;
+
+    Object *piece = newPiece(std::string(piece_length, 'x'));
+    Object *str = newPiece("");
+    auto start = std::chrono::steady_clock::now();
+    while(str->str_length < target)
+    {
+        std::string joined = std::string(stringValue(str)) + stringValue(piece);
+        str = newPiece(joined);
+    }
+    std::cout << "copying append to " << str->str_length << " bytes: " << msSince(start) << " ms\n";
+    MyMemory::current = NULL;
+}
+
+// the same loop through concatStrings, then one read that joins the rope
+void BenchRopeAppend(std::size_t target, std::size_t piece_length)
+{
+    MyMemory::Arena arena;
+    MyMemory::current = &arena;
+
+    Object *piece = newPiece(std::string(piece_length, 'x'));
+    Object *str = newPiece("");
+    auto start = std::chrono::steady_clock::now();
+    while(str->str_length < target)
+        str = concatStrings(str, piece);
+    double append_ms = msSince(start);
+
+    start = std::chrono::steady_clock::now();
+    std::size_t length = std::strlen(stringValue(str));
+    double join_ms = msSince(start);
+
+    std::cout << "rope append to " << length << " bytes: " << append_ms << " ms, first read " << join_ms << " ms\n";
+    MyMemory::current = NULL;
+}
+
+// counting the code points of a new string, then reading characters all over it
+void BenchIndexing(std::size_t target, std::string piece)
+{
+    MyMemory::Arena arena;
+    MyMemory::current = &arena;
+
+    std::string text;
+    while(text.size() < target)
+        text += piece;
+    auto start = std::chrono::steady_clock::now();
+    Object *str = newPiece(text);
+    double scan_ms = msSince(start);
+
+    long reads = 1000000;
+    std::size_t checksum = 0;
+    start = std::chrono::steady_clock::now();
+    for(long i = 0, k = 0; i < reads; i++, k = (k + 7919) % str->str_chars)
+        checksum += charOffset(str, k);
+    double index_ns = msSince(start) * 1e6 / reads;
+
+    std::cout << "indexing " << str->str_length << " bytes, " << str->str_chars << " code points: scan " << scan_ms
+              << " ms, " << index_ns << " ns/index (" << checksum % 10 << ")\n";
+    MyMemory::current = NULL;
+}
+
+// a needle that only matches at the very end, against std::string::find's byte loop
+void BenchFind(std::size_t length, std::string needle)
+{
+    std::string text;
+    while(text.size() < length)
+        text += "log line 1234 INFO request served in 12ms by worker-7\n";
+    text += needle;
+
+    int runs = 20;
+    const char *found = NULL;
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < runs; i++)
+        found = findBytes(text.data(), text.size(), needle.data(), needle.size());
+    double kernel_ms = msSince(start) / runs;
+
+    std::size_t position = 0;
+    start = std::chrono::steady_clock::now();
+    for(int i = 0; i < runs; i++)
+        position = text.find(needle);
+    double std_ms = msSince(start) / runs;
+
+    std::cout << "find \"" << needle << "\" in " << text.size() << " bytes: " << kernel_ms << " ms, std::string::find "
+              << std_ms << " ms (" << (found - text.data() == (long)position) << ")\n";
+}
+
+int main()
+{
+    // copying keeps every intermediate string in the arena, it is only run up to a size that fits
+    BenchCopyingAppend(200000, 100);
+    BenchRopeAppend(200000, 100);
+    BenchRopeAppend(10 * 1000 * 1000, 100);
+    BenchIndexing(10 * 1000 * 1000, "plain ascii text");
+    BenchIndexing(10 * 1000 * 1000, "a\u00e9\u20acx");
+    BenchFind(10 * 1000 * 1000, "ERROR");
+    BenchFind(10 * 1000 * 1000, "worker-8 failed");
+}
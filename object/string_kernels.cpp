@@ -0,0 +1,62 @@
+#include "string_kernels.h"
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define HAVE_AVX2_KERNELS
+#endif
+
+#ifdef HAVE_AVX2_KERNELS
+
+static bool haveAvx2()
+{
+    static bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+__attribute__((target("avx2"))) static const char *findAvx2(const char *haystack, std::size_t length, const char *needle,
+                                                           std::size_t needle_length)
+{
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[needle_length - 1]);
+    std::size_t end = length - needle_length + 1;
+    std::size_t i = 0;
+    for(; i + 32 <= end; i += 32)
+    {
+        __m256i block_first = _mm256_loadu_si256((const __m256i *)(haystack + i));
+        __m256i block_last = _mm256_loadu_si256((const __m256i *)(haystack + i + needle_length - 1));
+        __m256i both = _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first), _mm256_cmpeq_epi8(last, block_last));
+        unsigned int candidates = (unsigned int)_mm256_movemask_epi8(both);
+        while(candidates != 0)
+        {
+            std::size_t position = i + __builtin_ctz(candidates);
+            if(std::memcmp(haystack + position + 1, needle + 1, needle_length - 2) == 0)
+                return haystack + position;
+            candidates &= candidates - 1;
+        }
+    }
+    // fewer than 32 positions left
+    for(; i < end; i++)
+    {
+        if(haystack[i] == needle[0] && std::memcmp(haystack + i + 1, needle + 1, needle_length - 1) == 0)
+            return haystack + i;
+    }
+    return NULL;
+}
+
+#endif
+
+const char *findBytes(const char *haystack, std::size_t length, const char *needle, std::size_t needle_length)
+{
+    if(needle_length == 0)
+        return haystack;
+    if(needle_length > length)
+        return NULL;
+    if(needle_length == 1)
+        return (const char *)std::memchr(haystack, needle[0], length);
+#ifdef HAVE_AVX2_KERNELS
+    if(haveAvx2())
+        return findAvx2(haystack, length, needle, needle_length);
+#endif
+    return (const char *)memmem(haystack, length, needle, needle_length);
+}
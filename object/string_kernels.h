@@ -0,0 +1,12 @@
+#ifndef __STRING_KERNELS_HEADER__
+#define __STRING_KERNELS_HEADER__
+
+#include <cstddef>
+
+// The first occurrence of needle in haystack, NULL if there is none; an empty needle is found at
+// the start. Single bytes go to memchr. Longer needles are looked for with AVX2 when the cpu has
+// it, comparing their first and last bytes against 32 positions at once and checking only the
+// positions where both match; otherwise glibc's memmem, a two-way search, is used.
+const char *findBytes(const char *haystack, std::size_t length, const char *needle, std::size_t needle_length);
+
+#endif
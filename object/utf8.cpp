@@ -0,0 +1,125 @@
+#include "utf8.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define HAVE_AVX2_KERNELS
+#endif
+
+#define ASCII_MASK 0x8080808080808080ULL
+
+static std::size_t asciiRunScalar(const unsigned char *data, std::size_t length)
+{
+    std::size_t i = 0;
+    for(; i + 8 <= length; i += 8)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        if(word & ASCII_MASK)
+            break;
+    }
+    return i;
+}
+
+#ifdef HAVE_AVX2_KERNELS
+
+static bool haveAvx2()
+{
+    static bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+// the high bit of every byte lands in the mask, a zero mask is 32 ASCII bytes
+__attribute__((target("avx2"))) static std::size_t asciiRunAvx2(const unsigned char *data, std::size_t length)
+{
+    std::size_t i = 0;
+    for(; i + 32 <= length; i += 32)
+    {
+        __m256i block = _mm256_loadu_si256((const __m256i *)(data + i));
+        if(_mm256_movemask_epi8(block) != 0)
+            break;
+    }
+    return i + asciiRunScalar(data + i, length - i);
+}
+
+#endif
+
+// how many bytes from the start are ASCII, rounded down to whole blocks; the rest go byte by byte
+static std::size_t asciiRun(const unsigned char *data, std::size_t length)
+{
+#ifdef HAVE_AVX2_KERNELS
+    if(haveAvx2())
+        return asciiRunAvx2(data, length);
+#endif
+    return asciiRunScalar(data, length);
+}
+
+static bool isContinuation(unsigned char byte)
+{
+    return (byte & 0xC0) == 0x80;
+}
+
+// the length of the well-formed character at data, 0 if there is none; overlong forms, surrogates
+// and code points past U+10FFFF are rejected through the ranges allowed for the second byte
+static std::size_t validSequence(const unsigned char *data, std::size_t left)
+{
+    unsigned char lead = data[0];
+    if(lead < 0x80)
+        return 1;
+
+    std::size_t length;
+    unsigned char low = 0x80, high = 0xBF;
+    if(lead >= 0xC2 && lead <= 0xDF)
+        length = 2;
+    else if(lead >= 0xE0 && lead <= 0xEF)
+    {
+        length = 3;
+        if(lead == 0xE0)
+            low = 0xA0;
+        else if(lead == 0xED)
+            high = 0x9F;
+    }
+    else if(lead >= 0xF0 && lead <= 0xF4)
+    {
+        length = 4;
+        if(lead == 0xF0)
+            low = 0x90;
+        else if(lead == 0xF4)
+            high = 0x8F;
+    }
+    else
+        return 0;
+
+    if(length > left || data[1] < low || data[1] > high)
+        return 0;
+    for(std::size_t i = 2; i < length; i++)
+    {
+        if(!isContinuation(data[i]))
+            return 0;
+    }
+    return length;
+}
+
+bool scanUtf8(const char *text, std::size_t length, std::size_t &chars)
+{
+    const unsigned char *data = (const unsigned char *)text;
+    chars = 0;
+    std::size_t i = 0;
+    while(i < length)
+    {
+        std::size_t ascii = asciiRun(data + i, length - i);
+        chars += ascii;
+        i += ascii;
+        // a few characters at a time until the next ASCII run long enough for a block
+        for(std::size_t stop = i + 32; i < length && i < stop;)
+        {
+            std::size_t sequence = validSequence(data + i, length - i);
+            if(sequence == 0)
+                return false;
+            i += sequence;
+            chars += 1;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,23 @@
+#ifndef __UTF8_HEADER__
+#define __UTF8_HEADER__
+
+#include <cstddef>
+
+// Checks that data is well-formed UTF-8 and counts its code points into chars. Runs of ASCII are
+// skipped 32 bytes at a time with AVX2 when the cpu has it, 8 at a time otherwise; only the bytes
+// around other characters are decoded one by one. On false chars is left unspecified.
+bool scanUtf8(const char *data, std::size_t length, std::size_t &chars);
+
+// bytes in the character starting with lead, for text scanUtf8 accepted
+inline std::size_t utf8SequenceLength(unsigned char lead)
+{
+    if(lead < 0x80)
+        return 1;
+    if(lead < 0xE0)
+        return 2;
+    if(lead < 0xF0)
+        return 3;
+    return 4;
+}
+
+#endif
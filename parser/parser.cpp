@@ -1,4 +1,6 @@
 #include "parser.h"
+#include <cerrno>
+#include <cstdlib>
 
 std::unordered_map<TokenType, int> unordered_precedences = {{EQ,EQUALS},{NOT_EQ,EQUALS},{LT,LESSGREATER},{GT,LESSGREATER},
                                         {PLUS,SUM},{MINUS,SUM},{SLASH,PRODUCT},{ASTERISK,PRODUCT}, {LPAREN, CALL}, {LBRACKET, INDEX}};
@@ -63,22 +65,29 @@ Node parseInteger(Parser *p)
 {
     Node lit;
     lit.token = p->curToken;
-    int value;
-    try
-    {
-        value = std::stoi(p->curToken.Literal);
-    }
-    catch(std::invalid_argument const &e)
-    {
-        std::cerr << e.what() << '\n';
-    }
-    
-    lit.Value_int = value;
+    // literals past the range of long keep their digits, they are read as a BIGINT
+    errno = 0;
+    long value = std::strtol(p->curToken.Literal.c_str(), NULL, 10);
+    if(errno == ERANGE)
+        lit.Value_string = p->curToken.Literal;
+    else
+        lit.Value_int = value;
     lit.node_type = "Identifier";
     lit.which_identifier = "IntegerLiteral";
     return lit;
 }
 
+Node parseFloat(Parser *p)
+{
+    Node lit;
+    lit.token = p->curToken;
+    // the lexer only hands over well-formed literals, too large ones become inf
+    lit.Value_float = std::strtod(p->curToken.Literal.c_str(), NULL);
+    lit.node_type = "Identifier";
+    lit.which_identifier = "FloatLiteral";
+    return lit;
+}
+
 void noPrefixParseFnError(Parser *p, TokenType t)
 {
     p->errors.push_back("No prefix parse function for "+t+" found");
@@ -178,12 +187,14 @@ Node parseGroupExpression(Parser *p)
 {
     nextToken(p);
 
+    // the inner expression comes first, its closing parenthesis after it
+    Node exp = parseExpression(p,LOWEST);
     if(!expectPeek(p, RPAREN))
     {
         Node *identifier_null = new Node();
         return *identifier_null;
     }
-    return parseExpression(p,LOWEST);
+    return exp;
 }
 
 Node *parseBlockStatement(Parser *p)
@@ -293,6 +304,52 @@ Node parseWhileExpression(Parser *p)
     return *i;
 }
 
+// for (name in iterable) { body }
+Node parseForExpression(Parser *p)
+{
+    Node *i = new Node();
+    i->token = p->curToken;
+
+    Node identifier_null;
+
+    if(!expectPeek(p, LPAREN))
+    {
+        return identifier_null;
+    }
+    if(!expectPeek(p, IDENT))
+    {
+        return identifier_null;
+    }
+    Node *name = new Node();
+    name->token = p->curToken;
+    name->Value = p->curToken.Literal;
+    name->node_type = "Identifier";
+    i->Name_identifier = name;
+
+    if(!expectPeek(p, IN))
+    {
+        return identifier_null;
+    }
+
+    nextToken(p);
+    i->Value_identifier = new Node(parseExpression(p, LOWEST));
+
+    if(!expectPeek(p, RPAREN))
+    {
+        return identifier_null;
+    }
+
+    if(!expectPeek(p, LBRACE))
+    {
+        return identifier_null;
+    }
+    i->Body_statement = parseBlockStatement(p);
+
+    i->which_identifier = "ForExpression";
+    i->node_type = "Identifier";
+    return *i;
+}
+
 std::vector<Node*> parseFunctionParameters(Parser *p)
 {
     std::vector<Node *> params;
@@ -498,7 +555,7 @@ Node parseHashLiteral(Parser *p)
         }
         nextToken(p);
         Node *value = new Node(parseExpression(p, LOWEST));
-        hash->Pairs[key] = value;
+        hash->Pairs.push_back(std::make_pair(key, value));
 
         if(!peekTokenIs(p, RBRACE) && !expectPeek(p, COMMA))
             return hash_null;
@@ -532,12 +589,14 @@ Parser *New(Lexer *l)
 
     Node (*parseIdentifierPtr)(Parser *p);
     Node (*parseIntegerPtr)(Parser *p);
+    Node (*parseFloatPtr)(Parser *p);
     Node (*parsePrefixExpressionPtr)(Parser *p);
     Node (*parseBooleanPtr)(Parser *p);
     Node (*parseInfixExpressionPtr)(Parser *p, Node *left);
     Node (*parseGroupExpressionPtr)(Parser *p);
     Node (*parseIfExpressionPtr)(Parser *p);
     Node (*parseWhileExpressionPtr)(Parser *p);
+    Node (*parseForExpressionPtr)(Parser *p);
     Node (*parseFunctionLiteralPtr)(Parser *p);
     Node (*parseCallExpressionPtr)(Parser *p, Node *function);
     Node (*parseStringLiteralPtr)(Parser *p);
@@ -547,12 +606,14 @@ Parser *New(Lexer *l)
 
     parseIdentifierPtr = &parseIdentifier;
     parseIntegerPtr = &parseInteger;
+    parseFloatPtr = &parseFloat;
     parsePrefixExpressionPtr = &parsePrefixExpression;
     parseInfixExpressionPtr = &parseInfixExpression;
     parseBooleanPtr = &parseBoolean;
     parseGroupExpressionPtr = &parseGroupExpression;
     parseIfExpressionPtr =  &parseIfExpression;
     parseWhileExpressionPtr =  &parseWhileExpression;
+    parseForExpressionPtr = &parseForExpression;
     parseFunctionLiteralPtr = &parseFunctionLiteral;
     parseCallExpressionPtr = &parseCallExpression;
     parseStringLiteralPtr = &parseStringLiteral;
@@ -562,6 +623,7 @@ Parser *New(Lexer *l)
 
 	registerPrefix(p,IDENT, parseIdentifierPtr);
 	registerPrefix(p,INT, parseIntegerPtr);
+	registerPrefix(p,FLOAT, parseFloatPtr);
 	registerPrefix(p,BANG, parsePrefixExpressionPtr);
 	registerPrefix(p,MINUS, parsePrefixExpressionPtr);
 	registerPrefix(p,PLUS, parsePrefixExpressionPtr);
@@ -570,6 +632,7 @@ Parser *New(Lexer *l)
     registerPrefix(p, LPAREN, parseGroupExpressionPtr);
     registerPrefix(p, IF, parseIfExpressionPtr);
     registerPrefix(p, WHILE, parseWhileExpressionPtr);
+    registerPrefix(p, FOR, parseForExpressionPtr);
     registerPrefix(p, FUNCTION, parseFunctionLiteralPtr);
     registerPrefix(p, STRING, parseStringLiteralPtr);
     registerPrefix(p, LBRACKET, parseArrayLiteralPtr);
@@ -746,7 +809,6 @@ Node *ParseProgram(Parser *p)
         {
             program->Node_array.push_back(stmt);
         }
-        free(stmt);
 
         nextToken(p);
     }
@@ -48,6 +48,7 @@ Node *parseReturnStatement(Parser *p);
 Node *parseBlockStatement(Parser *p);
 
 Node parseWhileExpression(Parser *p);
+Node parseForExpression(Parser *p);
 Node parseIfExpression(Parser *p);
 Node parseFunctionLiteral(Parser *p);
 Node parseGroupExpression(Parser *p);
@@ -57,6 +58,7 @@ Node parsePrefixExpression(Parser *p);
 Node parseExpression(Parser *p, int precedence);
 Node parseIdentifier(Parser *p);
 Node parseInteger(Parser *p);
+Node parseFloat(Parser *p);
 Node parseCallExpression(Parser *p, Node *function_identifier);
 Node parseArrayLiteral(Parser *p);
 Node parseIndexExpression(Parser *p);
@@ -9,7 +9,9 @@ std::unordered_map<std::string, TokenType> keywords({
         {"else", ELSE},
         {"return", RETURN},
         {"while", WHILE},
-        {"break", BREAK}
+        {"break", BREAK},
+        {"for", FOR},
+        {"in", IN}
     });
 
 TokenType LookupIdent(std::string ident)
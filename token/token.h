@@ -10,6 +10,7 @@
 // Identifiers + literals
 #define IDENT "IDENT"
 #define INT "INT"
+#define FLOAT "FLOAT"
 
 // Operators
 #define ASSIGN "="
@@ -47,6 +48,8 @@
 #define RETURN "RETURN"
 #define WHILE "WHILE"
 #define BREAK "BREAK"
+#define FOR "FOR"
+#define IN "IN"
 
 #define STRING "STRING"
 
@@ -56,6 +59,8 @@ struct Token
 {
     TokenType Type;
     std::string Literal;
+    int Line = 0;
+    int Column = 0;
 };
 
 extern std::unordered_map<std::string, TokenType> keywords;